@@ -413,6 +413,8 @@ cSetup::cSetup(void)
   EPGPauseAfterScan = 0;
   EPGBugfixLevel = 3;
   EPGLinger = 0;
+  EPGBinaryData = 0;
+  EPGIncrementalSave = 0;
   SVDRPTimeout = 300;
   SVDRPPeering = 0;
   strn0cpy(SVDRPHostName, GetHostName(), sizeof(SVDRPHostName));
@@ -470,6 +472,7 @@ cSetup::cSetup(void)
   FontFixSize = 20;
   MaxVideoFileSize = MAXVIDEOFILESIZEDEFAULT;
   SplitEditedFiles = 0;
+  WriteBufferSize = 0;
   DelTimeshiftRec = 0;
   MinEventTimeout = 30;
   MinUserInactivity = 300;
@@ -500,6 +503,8 @@ cSetup::cSetup(void)
   ChannelsWrap = 0;
   ShowChannelNamesWithSource = 0;
   EmergencyExit = 1;
+  BufferHugePages = 0;
+  BufferNumaLocal = 0;
 }
 
 cSetup& cSetup::operator= (const cSetup &s)
@@ -644,6 +649,8 @@ bool cSetup::Parse(const char *Name, const char *Value)
   else if (!strcasecmp(Name, "EPGPauseAfterScan"))   EPGPauseAfterScan  = atoi(Value);
   else if (!strcasecmp(Name, "EPGBugfixLevel"))      EPGBugfixLevel     = atoi(Value);
   else if (!strcasecmp(Name, "EPGLinger"))           EPGLinger          = atoi(Value);
+  else if (!strcasecmp(Name, "EPGBinaryData"))       EPGBinaryData      = atoi(Value);
+  else if (!strcasecmp(Name, "EPGIncrementalSave"))  EPGIncrementalSave = atoi(Value);
   else if (!strcasecmp(Name, "SVDRPTimeout"))        SVDRPTimeout       = atoi(Value);
   else if (!strcasecmp(Name, "SVDRPPeering"))        SVDRPPeering       = atoi(Value);
   else if (!strcasecmp(Name, "SVDRPHostName"))     { if (*Value) strn0cpy(SVDRPHostName, Value, sizeof(SVDRPHostName)); }
@@ -701,6 +708,7 @@ bool cSetup::Parse(const char *Name, const char *Value)
   else if (!strcasecmp(Name, "FontFixSize"))         FontFixSize        = atoi(Value);
   else if (!strcasecmp(Name, "MaxVideoFileSize"))    MaxVideoFileSize   = atoi(Value);
   else if (!strcasecmp(Name, "SplitEditedFiles"))    SplitEditedFiles   = atoi(Value);
+  else if (!strcasecmp(Name, "WriteBufferSize"))     WriteBufferSize    = atoi(Value);
   else if (!strcasecmp(Name, "DelTimeshiftRec"))     DelTimeshiftRec    = atoi(Value);
   else if (!strcasecmp(Name, "MinEventTimeout"))     MinEventTimeout    = atoi(Value);
   else if (!strcasecmp(Name, "MinUserInactivity"))   MinUserInactivity  = atoi(Value);
@@ -731,6 +739,8 @@ bool cSetup::Parse(const char *Name, const char *Value)
   else if (!strcasecmp(Name, "ChannelsWrap"))        ChannelsWrap       = atoi(Value);
   else if (!strcasecmp(Name, "ShowChannelNamesWithSource")) ShowChannelNamesWithSource = atoi(Value);
   else if (!strcasecmp(Name, "EmergencyExit"))       EmergencyExit      = atoi(Value);
+  else if (!strcasecmp(Name, "BufferHugePages"))     BufferHugePages    = atoi(Value);
+  else if (!strcasecmp(Name, "BufferNumaLocal"))     BufferNumaLocal    = atoi(Value);
   else if (!strcasecmp(Name, "LastReplayed"))        cReplayControl::SetRecording(Value);
   else
      return false;
@@ -779,6 +789,8 @@ bool cSetup::Save(void)
   Store("EPGPauseAfterScan",  EPGPauseAfterScan);
   Store("EPGBugfixLevel",     EPGBugfixLevel);
   Store("EPGLinger",          EPGLinger);
+  Store("EPGBinaryData",      EPGBinaryData);
+  Store("EPGIncrementalSave", EPGIncrementalSave);
   Store("SVDRPTimeout",       SVDRPTimeout);
   Store("SVDRPPeering",       SVDRPPeering);
   Store("SVDRPHostName",      strcmp(SVDRPHostName, GetHostName()) ? SVDRPHostName : "");
@@ -836,6 +848,7 @@ bool cSetup::Save(void)
   Store("FontFixSize",        FontFixSize);
   Store("MaxVideoFileSize",   MaxVideoFileSize);
   Store("SplitEditedFiles",   SplitEditedFiles);
+  Store("WriteBufferSize",    WriteBufferSize);
   Store("DelTimeshiftRec",    DelTimeshiftRec);
   Store("MinEventTimeout",    MinEventTimeout);
   Store("MinUserInactivity",  MinUserInactivity);
@@ -866,6 +879,8 @@ bool cSetup::Save(void)
   Store("ChannelsWrap",       ChannelsWrap);
   Store("ShowChannelNamesWithSource", ShowChannelNamesWithSource);
   Store("EmergencyExit",      EmergencyExit);
+  Store("BufferHugePages",    BufferHugePages);
+  Store("BufferNumaLocal",    BufferNumaLocal);
   Store("LastReplayed",       cReplayControl::LastReplayed());
 
   Sort();
@@ -22,13 +22,13 @@
 
 // VDR's own version number:
 
-#define VDRVERSION  "2.7.9"
-#define VDRVERSNUM   20709  // Version * 10000 + Major * 100 + Minor
+#define VDRVERSION  "2.7.10"
+#define VDRVERSNUM   20710  // Version * 10000 + Major * 100 + Minor
 
 // The plugin API's version number:
 
-#define APIVERSION     "11"
-#define APIVERSNUM   30011
+#define APIVERSION     "12"
+#define APIVERSNUM   30012
 
 // When loading plugins, VDR searches files by their APIVERSION, which
 // is different from VDRVERSION. APIVERSION is a plain number, incremented
@@ -305,6 +305,8 @@ public:
   int EPGScanTimeout;
   int EPGBugfixLevel;
   int EPGLinger;
+  int EPGBinaryData;
+  int EPGIncrementalSave;
   int SVDRPTimeout;
   int SVDRPPeering;
   char SVDRPHostName[HOST_NAME_MAX];
@@ -351,6 +353,7 @@ public:
   int FontFixSize;
   int MaxVideoFileSize;
   int SplitEditedFiles;
+  int WriteBufferSize;
   int DelTimeshiftRec;
   int MinEventTimeout, MinUserInactivity;
   time_t NextWakeupTime;
@@ -378,6 +381,8 @@ public:
   int ChannelsWrap;
   int ShowChannelNamesWithSource;
   int EmergencyExit;
+  int BufferHugePages;
+  int BufferNumaLocal;
   int __EndData__;
   cString InitialChannel;
   cString DeviceBondings;
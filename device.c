@@ -112,6 +112,8 @@ cDevice::cDevice(void)
 
   for (int i = 0; i < MAXRECEIVERS; i++)
       receiver[i] = NULL;
+  memset(receiverMask, 0, sizeof(receiverMask));
+  packets = 0;
 
   if (numDevices < MAXDEVICES)
      device[numDevices++] = this;
@@ -1741,6 +1743,29 @@ bool cDevice::Receiving(bool Dummy) const
   return false;
 }
 
+void cDevice::GetMetrics(cStringList &Lines) const
+{
+  cMutexLock MutexLock(&mutexReceiver);
+  int NumReceivers = 0;
+  for (int i = 0; i < MAXRECEIVERS; i++) {
+      if (receiver[i])
+         NumReceivers++;
+      }
+  cString Line = cString::sprintf("device %d type=%s packets=%" PRId64 " receivers=%d", DeviceNumber() + 1, *DeviceType(), packets, NumReceivers);
+  if (eitFilter)
+     Line.Append(" ").Append(eitFilter->Metrics());
+  Lines.Append(strdup(Line));
+  for (int i = 0; i < MAXRECEIVERS; i++) {
+      if (cReceiver *Receiver = receiver[i]) {
+         cString Line = cString::sprintf("receiver %d.%d channel=%s priority=%d pids=%d packets=%" PRId64, DeviceNumber() + 1, i, *Receiver->ChannelID().ToString(), Receiver->Priority(), Receiver->numPids, Receiver->Packets());
+         cString Metrics = Receiver->Metrics();
+         if (*Metrics)
+            Line.Append(" ").Append(Metrics);
+         Lines.Append(strdup(Line));
+         }
+      }
+}
+
 #define TS_SCRAMBLING_TIMEOUT     3 // seconds to wait until a TS becomes unscrambled
 #define TS_SCRAMBLING_TIME_OK     3 // seconds before a Channel/CAM combination is marked as known to decrypt
 #define EIT_INJECTION_TIME       10 // seconds for which to inject EIT event
@@ -1751,62 +1776,74 @@ void cDevice::Action(void)
      while (Running()) {
            // Read data from the DVR device:
            uchar *b = NULL;
-           if (GetTSPacket(b)) {
-              if (b) {
-                 // Distribute the packet to all attached receivers:
+           int Count = 0;
+           if (GetTSPackets(b, Count)) {
+              if (b && Count > 0) {
+                 packets += Count;
                  Lock();
                  cCamSlot *cs = CamSlot();
-                 if (cs)
-                    cs->TsPostProcess(b);
-                 int Pid = TsPid(b);
-                 bool IsScrambled = TsIsScrambled(b);
-                 for (int i = 0; i < MAXRECEIVERS; i++) {
-                     cMutexLock MutexLock(&mutexReceiver);
-                     cReceiver *Receiver = receiver[i];
-                     if (Receiver && Receiver->WantsPid(Pid)) {
-                        Receiver->Receive(b, TS_SIZE);
-                        // Check whether the TS packet is scrambled:
-                        if (Receiver->startScrambleDetection) {
-                           if (cs) {
-                              int CamSlotNumber = cs->MasterSlotNumber();
-                              if (Receiver->lastScrambledPacket < Receiver->startScrambleDetection)
-                                 Receiver->lastScrambledPacket = Receiver->startScrambleDetection;
-                              time_t Now = time(NULL);
-                              if (IsScrambled) {
-                                 Receiver->lastScrambledPacket = Now;
-                                 if (Now - Receiver->startScrambleDetection > Receiver->scramblingTimeout) {
-                                    if (!cs->IsActivating() || Receiver->Priority() >= LIVEPRIORITY) {
-                                       if (Receiver->ChannelID().Valid()) {
-                                          dsyslog("CAM %d: won't decrypt channel %s, detaching receiver", CamSlotNumber, *Receiver->ChannelID().ToString());
-                                          ChannelCamRelations.SetChecked(Receiver->ChannelID(), CamSlotNumber);
-                                          }
-                                       Detach(Receiver);
-                                       }
-                                    }
-                                 }
-                              else if (Now - Receiver->lastScrambledPacket > TS_SCRAMBLING_TIME_OK) {
-                                 if (Receiver->ChannelID().Valid()) {
-                                    dsyslog("CAM %d: decrypts channel %s", CamSlotNumber, *Receiver->ChannelID().ToString());
-                                    ChannelCamRelations.SetDecrypt(Receiver->ChannelID(), CamSlotNumber);
-                                    }
-                                 Receiver->startScrambleDetection = 0;
-                                 }
-                              }
-                           }
-                        // Inject EIT event to avoid the CAMs parental rating prompt:
-                        if (Receiver->startEitInjection) {
-                           time_t Now = time(NULL);
-                           if (cCamSlot *cs = CamSlot()) {
-                              if (Now != Receiver->lastEitInjection) { // once per second
-                                 cs->InjectEit(Receiver->ChannelID().Sid());
-                                 Receiver->lastEitInjection = Now;
-                                 }
-                              }
-                           if (Now - Receiver->startEitInjection > EIT_INJECTION_TIME)
-                              Receiver->startEitInjection = 0;
-                           }
-                        }
+                 if (cs) {
+                    for (int n = 0; n < Count; n++)
+                        cs->TsPostProcess(b + n * TS_SIZE);
+                    }
+                 mutexReceiver.Lock();
+                 // Distribute runs of packets with the same PID to all attached receivers:
+                 for (int n = 0; n < Count; ) {
+                     uchar *p = b + n * TS_SIZE;
+                     int Pid = TsPid(p);
+                     bool IsScrambled = false;
+                     int l = TsPidRun(p, Count - n, &IsScrambled);
+                     n += l;
+                     uint16_t Mask = receiverMask[Pid];
+                     for (int i = 0; Mask; i++, Mask >>= 1) {
+                         cReceiver *Receiver = receiver[i];
+                         if ((Mask & 1) && Receiver) {
+                            Receiver->ReceivePackets(p, l);
+                            Receiver->packets += l;
+                            // Check whether the TS packets are scrambled:
+                            if (Receiver->startScrambleDetection) {
+                               if (cs) {
+                                  int CamSlotNumber = cs->MasterSlotNumber();
+                                  if (Receiver->lastScrambledPacket < Receiver->startScrambleDetection)
+                                     Receiver->lastScrambledPacket = Receiver->startScrambleDetection;
+                                  time_t Now = time(NULL);
+                                  if (IsScrambled) {
+                                     Receiver->lastScrambledPacket = Now;
+                                     if (Now - Receiver->startScrambleDetection > Receiver->scramblingTimeout) {
+                                        if (!cs->IsActivating() || Receiver->Priority() >= LIVEPRIORITY) {
+                                           if (Receiver->ChannelID().Valid()) {
+                                              dsyslog("CAM %d: won't decrypt channel %s, detaching receiver", CamSlotNumber, *Receiver->ChannelID().ToString());
+                                              ChannelCamRelations.SetChecked(Receiver->ChannelID(), CamSlotNumber);
+                                              }
+                                           Detach(Receiver);
+                                           }
+                                        }
+                                     }
+                                  else if (Now - Receiver->lastScrambledPacket > TS_SCRAMBLING_TIME_OK) {
+                                     if (Receiver->ChannelID().Valid()) {
+                                        dsyslog("CAM %d: decrypts channel %s", CamSlotNumber, *Receiver->ChannelID().ToString());
+                                        ChannelCamRelations.SetDecrypt(Receiver->ChannelID(), CamSlotNumber);
+                                        }
+                                     Receiver->startScrambleDetection = 0;
+                                     }
+                                  }
+                               }
+                            // Inject EIT event to avoid the CAMs parental rating prompt:
+                            if (Receiver->startEitInjection) {
+                               time_t Now = time(NULL);
+                               if (cCamSlot *cs = CamSlot()) {
+                                  if (Now != Receiver->lastEitInjection) { // once per second
+                                     cs->InjectEit(Receiver->ChannelID().Sid());
+                                     Receiver->lastEitInjection = Now;
+                                     }
+                                  }
+                               if (Now - Receiver->startEitInjection > EIT_INJECTION_TIME)
+                                  Receiver->startEitInjection = 0;
+                               }
+                            }
+                         }
                      }
+                 mutexReceiver.Unlock();
                  Unlock();
                  }
               }
@@ -1831,6 +1868,29 @@ bool cDevice::GetTSPacket(uchar *&Data)
   return false;
 }
 
+bool cDevice::GetTSPackets(uchar *&Data, int &Count)
+{
+  Data = NULL;
+  Count = 0;
+  if (GetTSPacket(Data)) {
+     if (Data)
+        Count = 1;
+     return true;
+     }
+  return false;
+}
+
+void cDevice::UpdateReceiverMask(void)
+{
+  memset(receiverMask, 0, sizeof(receiverMask));
+  for (int i = 0; i < MAXRECEIVERS; i++) {
+      if (cReceiver *Receiver = receiver[i]) {
+         for (int n = 0; n < Receiver->numPids; n++)
+             receiverMask[Receiver->pids[n] & (MAXPID - 1)] |= 1 << i;
+         }
+      }
+}
+
 bool cDevice::AttachReceiver(cReceiver *Receiver)
 {
   if (!Receiver)
@@ -1859,6 +1919,7 @@ bool cDevice::AttachReceiver(cReceiver *Receiver)
          Receiver->Activate(true);
          Receiver->device = this;
          receiver[i] = Receiver;
+         UpdateReceiverMask();
          if (camSlot && Receiver->priority > MINPRIORITY) { // priority check to avoid an infinite loop with the CAM slot's caPidReceiver
             camSlot->StartDecrypting();
             if (camSlot->WantsTsData()) {
@@ -1897,6 +1958,7 @@ void cDevice::Detach(cReceiver *Receiver, bool ReleaseCam)
       else if (receiver[i])
          receiversLeft = true;
       }
+  UpdateReceiverMask();
   if (patFilter && Receiver->ChannelID().Valid())
      patFilter->Release(Receiver->ChannelID().Sid());
   mutexReceiver.Unlock();
@@ -1919,10 +1981,10 @@ void cDevice::DetachAll(int Pid)
 {
   if (Pid) {
      cMutexLock MutexLock(&mutexReceiver);
-     for (int i = 0; i < MAXRECEIVERS; i++) {
-         cReceiver *Receiver = receiver[i];
-         if (Receiver && Receiver->WantsPid(Pid))
-            Detach(Receiver, false);
+     uint16_t Mask = receiverMask[Pid & (MAXPID - 1)];
+     for (int i = 0; Mask; i++, Mask >>= 1) {
+         if ((Mask & 1) && receiver[i])
+            Detach(receiver[i], false);
          }
      ReleaseCamSlot();
      }
@@ -1938,12 +2000,21 @@ void cDevice::DetachAllReceivers(void)
 
 // --- cTSBuffer -------------------------------------------------------------
 
+#define TSBUFFERCHUNK     KILOBYTE(128) // the amount of data we would like to get with each read
+#define TSBUFFERMINWAIT   2 // ms
+#define TSBUFFERMAXWAIT  25 // ms
+#define TSBUFFERDVRSIZE  (10 * TS_SIZE * 1024) // the default size of the driver's DVR buffer
+#define TSBUFFERRATEINT 500 // ms between updates of the measured data rate
+
 cTSBuffer::cTSBuffer(int File, int Size, int DeviceNumber)
 {
   SetDescription("device %d TS buffer", DeviceNumber);
   f = File;
   deviceNumber = DeviceNumber;
   delivered = 0;
+  bytesPerSecond = 0;
+  memset(readSizes, 0, sizeof(readSizes));
+  memset(waitTimes, 0, sizeof(waitTimes));
   ringBuffer = new cRingBufferLinear(Size, TS_SIZE, true, "TS");
   ringBuffer->SetTimeouts(100, 100);
   ringBuffer->SetIoThrottle();
@@ -1953,13 +2024,50 @@ cTSBuffer::cTSBuffer(int File, int Size, int DeviceNumber)
 cTSBuffer::~cTSBuffer()
 {
   Cancel(3);
+  LogStatistics();
   delete ringBuffer;
 }
 
+static int Log2Bucket(int Value, int NumBuckets)
+{
+  int b = 0;
+  while (Value > 1 && b < NumBuckets - 1) {
+        Value >>= 1;
+        b++;
+        }
+  return b;
+}
+
+void cTSBuffer::LogStatistics(void)
+{
+  cString Sizes;
+  cString Waits;
+  for (int i = 0; i < TSBUFFERHISTSIZE; i++) {
+      Sizes = cString::sprintf("%s %d", *Sizes ? *Sizes : "", readSizes[i]);
+      Waits = cString::sprintf("%s %d", *Waits ? *Waits : "", waitTimes[i]);
+      }
+  dsyslog("device %d TS buffer read sizes (log2 KB):%s", deviceNumber, *Sizes);
+  dsyslog("device %d TS buffer wait times (log2 ms):%s", deviceNumber, *Waits);
+}
+
+int cTSBuffer::WaitTime(void)
+{
+  if (bytesPerSecond <= 0)
+     return TSBUFFERMINWAIT; // data rate not yet known (like right after switching channels)
+  int Wait = TSBUFFERCHUNK * 1000LL / bytesPerSecond;
+  if (ringBuffer->Available() > ringBuffer->Free())
+     Wait = TSBUFFERMAXWAIT; // the consumer is busy, so there's no need to hurry
+  // Make sure the driver's DVR buffer is never more than half full:
+  int MaxWait = min(TSBUFFERMAXWAIT, int(TSBUFFERDVRSIZE / 2 * 1000LL / bytesPerSecond));
+  return constrain(Wait, TSBUFFERMINWAIT, max(MaxWait, TSBUFFERMINWAIT));
+}
+
 void cTSBuffer::Action(void)
 {
   if (ringBuffer) {
      bool firstRead = true;
+     int Bytes = 0;
+     cTimeMs RateTimer;
      cPoller Poller(f);
      while (Running()) {
            if (firstRead || Poller.Poll(100)) {
@@ -1973,7 +2081,19 @@ void cTSBuffer::Action(void)
                     break;
                     }
                  }
-              cCondWait::SleepMs(10); // avoids small chunks of data, which cause high CPU usage, esp. on ARM CPUs
+              if (r > 0) {
+                 Bytes += r;
+                 readSizes[Log2Bucket(r / KILOBYTE(1), TSBUFFERHISTSIZE)]++;
+                 }
+              if (RateTimer.Elapsed() >= TSBUFFERRATEINT) {
+                 bytesPerSecond = Bytes * 1000LL / RateTimer.Elapsed();
+                 Bytes = 0;
+                 RateTimer.Set();
+                 }
+              // Waiting a little while avoids small chunks of data, which cause high CPU usage, esp. on ARM CPUs:
+              int Wait = WaitTime();
+              waitTimes[Log2Bucket(Wait, TSBUFFERHISTSIZE)]++;
+              cCondWait::SleepMs(Wait);
               }
            }
      }
@@ -1991,12 +2111,8 @@ uchar *cTSBuffer::Get(int *Available, bool CheckAvailable)
   uchar *p = ringBuffer->Get(Count);
   if (p && Count >= TS_SIZE) {
      if (*p != TS_SYNC_BYTE) {
-        for (int i = 1; i < Count; i++) {
-            if (p[i] == TS_SYNC_BYTE) {
-               Count = i;
-               break;
-               }
-            }
+        if (uchar *q = (uchar *)memchr(p + 1, TS_SYNC_BYTE, Count - 1))
+           Count = q - p;
         ringBuffer->Del(Count);
         esyslog("ERROR: skipped %d bytes to sync on TS packet on device %d", Count, deviceNumber);
         return NULL;
@@ -2009,6 +2125,21 @@ uchar *cTSBuffer::Get(int *Available, bool CheckAvailable)
   return NULL;
 }
 
+uchar *cTSBuffer::GetPackets(int &Count, int MaxCount)
+{
+  int Available = 0;
+  Count = 0;
+  uchar *p = Get(&Available);
+  if (p) {
+     int n = min(Available / TS_SIZE, MaxCount);
+     Count = 1;
+     while (Count < n && p[Count * TS_SIZE] == TS_SYNC_BYTE)
+           Count++;
+     Skip(Count * TS_SIZE);
+     }
+  return p;
+}
+
 void cTSBuffer::Skip(int Count)
 {
   delivered = Count;
@@ -28,7 +28,7 @@
 
 #define MAXDEVICES         16 // the maximum number of devices in the system
 #define MAXPIDHANDLES      64 // the maximum number of different PIDs per device
-#define MAXRECEIVERS       16 // the maximum number of receivers per device
+#define MAXRECEIVERS       16 // the maximum number of receivers per device (must fit into the bits of cDevice::receiverMask)
 #define MAXVOLUME         255
 #define VOLUMEDELTA       (MAXVOLUME / Setup.VolumeSteps) // used to increase/decrease the volume
 #define MAXOCCUPIEDTIMEOUT 99 // max. time (in seconds) a device may be occupied
@@ -846,6 +846,12 @@ public:
 private:
   mutable cMutex mutexReceiver;
   cReceiver *receiver[MAXRECEIVERS];
+  uint16_t receiverMask[MAXPID]; // bit i is set if receiver[i] wants the given PID
+  int64_t packets; // the number of TS packets received so far
+  void UpdateReceiverMask(void);
+      ///< Rebuilds the table that maps PIDs to the receivers that want them.
+      ///< Must be called with mutexReceiver locked whenever a receiver is attached,
+      ///< detached, or changes its PIDs while being attached.
 public:
   int Priority(bool IgnoreOccupied = false) const;
       ///< Returns the priority of the current receiving session (-MAXPRIORITY..MAXPRIORITY),
@@ -864,6 +870,16 @@ protected:
       ///< new data available, Data will be set to NULL. The function returns
       ///< false in case of a non recoverable error, otherwise it returns true,
       ///< even if Data is NULL.
+  virtual bool GetTSPackets(uchar *&Data, int &Count);
+      ///< Gets a contiguous run of TS packets from the DVR of this device and
+      ///< returns a pointer to the first one in Data and the number of packets in
+      ///< Count. All packets are guaranteed to start with a TS_SYNC_BYTE. If there
+      ///< is currently no new data available, Data will be set to NULL and Count
+      ///< to 0. The return value has the same meaning as for GetTSPacket().
+      ///< The default implementation calls GetTSPacket() and thus always delivers
+      ///< at most one packet. A derived device that can hand out larger blocks
+      ///< of data (like one that uses a cTSBuffer) should reimplement this
+      ///< function in order to reduce the per packet overhead in Action().
 public:
   bool Receiving(bool Dummy = false) const;
        ///< Returns true if we are currently receiving. The parameter has no meaning (for backwards compatibility only).
@@ -878,22 +894,43 @@ public:
        ///< Detaches all receivers from this device for this pid.
   virtual void DetachAllReceivers(void);
        ///< Detaches all receivers from this device.
+  void GetMetrics(cStringList &Lines) const;
+       ///< Appends lines with runtime metrics of this device and all of its receivers
+       ///< to Lines. The first line has the form "device <number> key=value..."
+       ///< (including the metrics of the device's EIT filter, see cEitFilter::Metrics()),
+       ///< followed by one line of the form "receiver <number>.<index> key=value..."
+       ///< for each receiver that is currently attached to this device. Any metrics
+       ///< the receiver itself provides (see cReceiver::Metrics()) are appended to
+       ///< its line.
   };
 
 /// Derived cDevice classes that can receive channels will have to provide
-/// Transport Stream (TS) packets one at a time. cTSBuffer implements a
+/// Transport Stream (TS) packets, either one at a time or in contiguous runs
+/// (see GetTSPacket() and GetTSPackets()). cTSBuffer implements a
 /// simple buffer that allows the device to read a larger amount of data
 /// from the driver with each call to Read(), thus avoiding the overhead
-/// of getting each TS packet separately from the driver. It also makes
+/// of getting each TS packet separately from the driver. The time it waits
+/// between reads adapts to the data rate, so that high data rates result in
+/// fewer, larger reads, while channel switching isn't delayed. It also makes
 /// sure the returned data points to a TS packet and automatically
 /// re-synchronizes after broken packets.
 
+#define TSBUFFERHISTSIZE 12 // the number of buckets in cTSBuffer's statistics
+#define MAXTSPACKETSPERRUN 64 // the maximum number of TS packets a device should hand to cDevice::Action() at once
+
 class cTSBuffer : public cThread {
 private:
   int f;
   int deviceNumber;
   int delivered;
+  int bytesPerSecond;
+  int readSizes[TSBUFFERHISTSIZE];
+  int waitTimes[TSBUFFERHISTSIZE];
   cRingBufferLinear *ringBuffer;
+  int WaitTime(void);
+      ///< Returns the time (in ms) to wait after reading from the driver, depending
+      ///< on the measured data rate and the fill level of the ring buffer.
+  void LogStatistics(void);
   virtual void Action(void) override;
 public:
   cTSBuffer(int File, int Size, int DeviceNumber);
@@ -909,6 +946,12 @@ public:
      ///< at least TS_SIZE bytes before trying to get any data from it. Otherwise, if
      ///< the buffer is empty, this function will wait a little while for the buffer
      ///< to be filled again.
+  uchar *GetPackets(int &Count, int MaxCount);
+     ///< Returns a pointer to a contiguous run of up to MaxCount TS packets, each of
+     ///< which starts with a TS_SYNC_BYTE. The actual number of packets is returned
+     ///< in Count. If no data is available, NULL is returned and Count is 0.
+     ///< The next call to Get() or GetPackets() will continue after the returned
+     ///< packets, unless Skip() is called.
   void Skip(int Count);
      ///< If after a call to Get() more or less than TS_SIZE of the available data
      ///< has been processed, a call to Skip() with the number of processed bytes
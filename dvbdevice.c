@@ -2404,6 +2404,19 @@ bool cDvbDevice::GetTSPacket(uchar *&Data)
   return false;
 }
 
+bool cDvbDevice::GetTSPackets(uchar *&Data, int &Count)
+{
+  if (tsBuffer) {
+     if (cCamSlot *cs = CamSlot()) {
+        if (cs->WantsTsData())
+           return cDevice::GetTSPackets(Data, Count); // the CAM decrypts one packet at a time
+        }
+     Data = tsBuffer->GetPackets(Count, MAXTSPACKETSPERRUN);
+     return true;
+     }
+  return false;
+}
+
 void cDvbDevice::DetachAllReceivers(void)
 {
   cMutexLock MutexLock(&bondMutex);
@@ -286,6 +286,7 @@ protected:
   virtual bool OpenDvr(void) override;
   virtual void CloseDvr(void) override;
   virtual bool GetTSPacket(uchar *&Data) override;
+  virtual bool GetTSPackets(uchar *&Data, int &Count) override;
   virtual void DetachAllReceivers(void) override;
   };
 
@@ -17,7 +17,31 @@
 
 // --- cPtsIndex -------------------------------------------------------------
 
+// cPtsIndex maps the PTS values delivered by the device to frame indexes of the
+// recording. The primary source for this are the frames that have been played
+// recently, which give exact results. A PTS that is outside the range of these
+// (for instance when skipping through the recording) is looked up in the whole
+// recording, using the PTS values of the recording's independent frames. These are
+// taken from the frames that are played and, for any other I-frame, read from the
+// recording's data files when needed, and are cached, so that a lookup, which does
+// a binary search over the I-frames, only needs to access the files the first time
+// it hits an unknown I-frame. The frames between two I-frames are interpolated, so
+// this also works for recordings with variable frame rates.
+// The binary search requires the PTS values to increase throughout the recording,
+// which is the case for recordings of a single broadcast as well as edited
+// recordings (the cutter makes the PTS values continuous), but not necessarily for
+// a timer recording across a broadcaster's PTS reset. Therefore the PTS values of
+// any two neighboring known I-frames are checked to fit the number of frames between
+// them, and if they don't, the recording wide lookup is no longer used and frames
+// are counted from the nearest recently played frame instead. Since some devices don't deliver the most
+// significant bit of the STC, only 32 bits are used, relative to the PTS of the
+// first I-frame, which is sufficient for recordings of up to about 12 hours.
+
 #define PTSINDEX_ENTRIES 1024
+#define PTSREADSIZE      (TS_SIZE * 64) // the number of bytes read from a frame to get its PTS
+#define PTSBEFORESTART   0xF0000000 // relative PTS values at or above this are before the start of the recording
+#define MAXGOPTICKS      (10 * PTSTICKS) // I-frames that are further apart are not used for interpolation
+#define PTSRATETOLERANCE 4 // the factor by which the actual frame rate may differ from the nominal one
 
 class cPtsIndex {
 private:
@@ -29,22 +53,73 @@ private:
   tPtsIndex pi[PTSINDEX_ENTRIES];
   int w, r;
   int lastFound;
-  cMutex mutex;
+  cIndexFile *index;
+  cFileName *fileName;
+  cString recordingName;
+  bool isPesRecording;
+  double framesPerSecond;
+  cVector<int> iFrames; // the I-frames with known PTS values, in ascending order
+  cVector<uint32_t> iFramePts; // the PTS values of the I-frames in iFrames
+  bool ascending; // false if the PTS values of the I-frames have turned out not to be ascending
+  cMutex mutex; // protects the recently played frames and the known I-frames
+  cMutex fileMutex; // protects fileName, which is accessed without holding mutex
+  int FindNearest(uint32_t Pts, uint32_t &NearestPts, bool &InRange);
+  int FindIFrame(int Index);
+  bool Plausible(int Index1, uint32_t Pts1, int Index2, uint32_t Pts2);
+  void StorePts(int Index, uint32_t Pts);
+  bool ReadPts(int Index, uint32_t &Pts);
+  bool GetPts(int Index, uint32_t &Pts);
+  bool Ascending(void);
+  double FrameTicks(int IFrame);
+  int Lookup(uint32_t Pts);
+  bool GetFramePts(int Index, uint32_t &Pts);
 public:
   cPtsIndex(void);
+  ~cPtsIndex();
+  void SetIndex(cIndexFile *Index, const char *FileName, bool IsPesRecording, double FramesPerSecond);
   void Clear(void);
   bool IsEmpty(void);
-  void Put(uint32_t Pts, int Index, bool Independent);
+  void Put(int64_t Pts, int Index, bool Independent);
+       ///< Pts is negative if the frame has no PTS.
   int FindIndex(uint32_t Pts, bool Still);
   int FindFrameNumber(uint32_t Pts, bool Forward, bool Still);
+  int SkipSeconds(int Index, int Seconds);
+       ///< Returns the index of the frame that is played the given number of Seconds
+       ///< after (or before, if Seconds is negative) the one at Index, or -1 if this
+       ///< can't be determined from the PTS values of the recording.
   };
 
 cPtsIndex::cPtsIndex(void)
 {
   lastFound = 0;
+  index = NULL;
+  fileName = NULL;
+  isPesRecording = false;
+  framesPerSecond = DEFAULTFRAMESPERSECOND;
+  ascending = true;
   Clear();
 }
 
+cPtsIndex::~cPtsIndex()
+{
+  delete fileName;
+}
+
+void cPtsIndex::SetIndex(cIndexFile *Index, const char *FileName, bool IsPesRecording, double FramesPerSecond)
+{
+  cMutexLock MutexLock(&mutex);
+  cMutexLock FileMutexLock(&fileMutex);
+  index = Index;
+  delete fileName;
+  fileName = Index ? new cFileName(FileName, false, false, IsPesRecording) : NULL;
+  recordingName = FileName;
+  isPesRecording = IsPesRecording;
+  framesPerSecond = FramesPerSecond > 0 ? FramesPerSecond : DEFAULTFRAMESPERSECOND;
+  iFrames.Clear();
+  iFramePts.Clear();
+  ascending = true;
+}
+
 void cPtsIndex::Clear(void)
 {
   cMutexLock MutexLock(&mutex);
@@ -57,24 +132,28 @@ bool cPtsIndex::IsEmpty(void)
   return w == r;
 }
 
-void cPtsIndex::Put(uint32_t Pts, int Index, bool Independent)
+void cPtsIndex::Put(int64_t Pts, int Index, bool Independent)
 {
   cMutexLock MutexLock(&mutex);
-  pi[w].pts = Pts;
+  pi[w].pts = uint32_t(Pts);
   pi[w].independent = Independent;
   pi[w].index = Index;
   w = (w + 1) % PTSINDEX_ENTRIES;
   if (w == r)
      r = (r + 1) % PTSINDEX_ENTRIES;
+  if (Independent && Index >= 0 && Pts >= 0 && index)
+     StorePts(Index, uint32_t(Pts));
 }
 
-int cPtsIndex::FindIndex(uint32_t Pts, bool Still)
+int cPtsIndex::FindNearest(uint32_t Pts, uint32_t &NearestPts, bool &InRange)
 {
-  cMutexLock MutexLock(&mutex);
-  if (w == r || Pts == 0 && !Still) // while 0 is a valid PTS, DeviceGetSTC() might return 0 if, after a jump,  the device hasn't displayed a frame, yet
-     return lastFound; // list is empty, let's not jump way off the last known position
+  // Returns the index of the recently played frame with the PTS closest to the given one.
+  // InRange tells whether Pts is within the range of the PTS values of these frames.
   uint32_t Delta = 0xFFFFFFFF;
   int Index = -1;
+  int32_t Min = 0;
+  int32_t Max = 0;
+  uint32_t Ref = pi[(w + PTSINDEX_ENTRIES - 1) % PTSINDEX_ENTRIES].pts; // the most recently played frame
   for (int i = w; i != r; ) {
       if (--i < 0)
          i = PTSINDEX_ENTRIES - 1;
@@ -84,46 +163,252 @@ int cPtsIndex::FindIndex(uint32_t Pts, bool Still)
       if (d < Delta) {
          Delta = d;
          Index = pi[i].index;
+         NearestPts = pi[i].pts;
          }
+      int32_t p = int32_t(pi[i].pts - Ref); // typecast handles rollover
+      Min = min(Min, p);
+      Max = max(Max, p);
       }
-  lastFound = Index;
+  int32_t Frame = int32_t(PTSTICKS / framesPerSecond);
+  int32_t p = int32_t(Pts - Ref);
+  InRange = Min - Frame <= p && p <= Max + Frame;
   return Index;
 }
 
+int cPtsIndex::FindIFrame(int Index)
+{
+  // Binary search for the first known I-frame at or after Index:
+  int l = 0;
+  int h = iFrames.Size();
+  while (l < h) {
+        int m = (l + h) / 2;
+        if (iFrames[m] < Index)
+           l = m + 1;
+        else
+           h = m;
+        }
+  return l;
+}
+
+bool cPtsIndex::Plausible(int Index1, uint32_t Pts1, int Index2, uint32_t Pts2)
+{
+  // Checks whether the PTS values of the frames Index1 < Index2 fit the number of frames between them:
+  double Ticks = (Index2 - Index1) * PTSTICKS / framesPerSecond;
+  double d = uint32_t(Pts2 - Pts1);
+  return d > 0 && d >= Ticks / PTSRATETOLERANCE && d <= Ticks * PTSRATETOLERANCE + MAXGOPTICKS;
+}
+
+void cPtsIndex::StorePts(int Index, uint32_t Pts)
+{
+  int i = FindIFrame(Index);
+  if (i >= iFrames.Size() || iFrames[i] != Index) {
+     iFrames.Insert(Index, i);
+     iFramePts.Insert(Pts, i);
+     if (ascending) {
+        if (i > 0 && !Plausible(iFrames[i - 1], iFramePts[i - 1], Index, Pts) || i + 1 < iFrames.Size() && !Plausible(Index, Pts, iFrames[i + 1], iFramePts[i + 1])) {
+           dsyslog("PTS values of recording %s are not ascending (at frame %d)", *recordingName, Index);
+           ascending = false;
+           }
+        }
+     }
+}
+
+bool cPtsIndex::ReadPts(int Index, uint32_t &Pts)
+{
+  cMutexLock MutexLock(&fileMutex);
+  uint16_t FileNumber;
+  off_t FileOffset;
+  int Length;
+  if (fileName && index->Get(Index, &FileNumber, &FileOffset, NULL, &Length)) {
+     if (cUnbufferedFile *f = fileName->SetOffset(FileNumber, FileOffset)) {
+        uchar b[PTSREADSIZE];
+        int r = ReadFrame(f, b, Length < 0 ? int(sizeof(b)) : min(Length, int(sizeof(b))), sizeof(b));
+        if (r > 0) {
+           int64_t p = isPesRecording ? (PesHasPts(b) ? PesGetPts(b) : -1) : TsGetPts(b, r);
+           if (p >= 0) {
+              Pts = uint32_t(p);
+              return true;
+              }
+           }
+        }
+     }
+  return false;
+}
+
+bool cPtsIndex::GetPts(int Index, uint32_t &Pts)
+{
+  {
+    cMutexLock MutexLock(&mutex);
+    int i = FindIFrame(Index);
+    if (i < iFrames.Size() && iFrames[i] == Index) {
+       Pts = iFramePts[i];
+       return true;
+       }
+  }
+  // Read the PTS from the recording, without blocking Put():
+  if (ReadPts(Index, Pts)) {
+     cMutexLock MutexLock(&mutex);
+     StorePts(Index, Pts);
+     return true;
+     }
+  return false;
+}
+
+bool cPtsIndex::Ascending(void)
+{
+  cMutexLock MutexLock(&mutex);
+  return ascending;
+}
+
+double cPtsIndex::FrameTicks(int IFrame)
+{
+  // Determine the duration of the frames in the GOP starting at IFrame from the
+  // PTS of the next I-frame, or, at the end of the recording, the previous one:
+  for (int i = 0; i < 2; i++) {
+      int From = IFrame;
+      int To = index->GetNextIFrame(IFrame, i == 0);
+      if (i)
+         swap(From, To);
+      uint32_t FromPts, ToPts;
+      if (From >= 0 && To > From && GetPts(From, FromPts) && GetPts(To, ToPts) && ToPts != FromPts && uint32_t(ToPts - FromPts) <= MAXGOPTICKS)
+         return double(uint32_t(ToPts - FromPts)) / (To - From);
+      }
+  return PTSTICKS / framesPerSecond;
+}
+
+int cPtsIndex::Lookup(uint32_t Pts)
+{
+  if (!index || !Ascending())
+     return -1;
+  int First = index->GetNextIFrame(-1, true);
+  uint32_t FirstPts;
+  if (First < 0 || !GetPts(First, FirstPts))
+     return -1;
+  uint32_t Rel = Pts - FirstPts;
+  if (Rel >= PTSBEFORESTART)
+     return First;
+  // Binary search for the last I-frame with a PTS at or before the given one:
+  int l = First; // an I-frame at or before Pts
+  int h = index->Last() + 1; // any I-frame at or after h is after Pts
+  while (h - l > 1) {
+        int m = (l + h) / 2;
+        int i = index->GetNextIFrame(m - 1, true); // the first I-frame at or after m
+        uint32_t p;
+        if (i < 0 || i >= h)
+           h = m;
+        else if (!GetPts(i, p))
+           return -1;
+        else if (uint32_t(p - FirstPts) <= Rel)
+           l = i;
+        else
+           h = i;
+        }
+  // Interpolate the frames up to the next I-frame:
+  uint32_t LPts;
+  if (!GetPts(l, LPts))
+     return -1;
+  int Index = l + int(round(uint32_t(Pts - LPts) / FrameTicks(l)));
+  int Next = index->GetNextIFrame(l, true);
+  if (!Ascending())
+     return -1; // the I-frames read during the search have revealed that the PTS values are not ascending
+  return min(Index, Next > l ? Next - 1 : index->Last());
+}
+
+bool cPtsIndex::GetFramePts(int Index, uint32_t &Pts)
+{
+  if (!index || !Ascending())
+     return false;
+  int l = index->GetNextIFrame(Index + 1, false); // the last I-frame at or before Index
+  uint32_t LPts;
+  if (l < 0 || !GetPts(l, LPts))
+     return false;
+  Pts = LPts + uint32_t(round((Index - l) * FrameTicks(l)));
+  return true;
+}
+
+int cPtsIndex::FindIndex(uint32_t Pts, bool Still)
+{
+  int Index;
+  uint32_t NearestPts;
+  {
+    cMutexLock MutexLock(&mutex);
+    if (w == r || Pts == 0 && !Still) // while 0 is a valid PTS, DeviceGetSTC() might return 0 if, after a jump,  the device hasn't displayed a frame, yet
+       return lastFound; // list is empty, let's not jump way off the last known position
+    bool InRange;
+    Index = FindNearest(Pts, NearestPts, InRange);
+    if (InRange) {
+       lastFound = Index;
+       return Index;
+       }
+  }
+  // The PTS is outside the range of the recently played frames, so look it up in the
+  // whole recording (the mutex is not held here, because this may need to read from
+  // the recording), or count the frames from the nearest played one:
+  int i = Lookup(Pts);
+  if (i < 0)
+     i = max(Index + int(round(int32_t(Pts - NearestPts) * framesPerSecond / PTSTICKS)), 0);
+  cMutexLock MutexLock(&mutex);
+  lastFound = i;
+  return lastFound;
+}
+
 int cPtsIndex::FindFrameNumber(uint32_t Pts, bool Forward, bool Still)
 {
   if (!Forward)
      return FindIndex(Pts, Still); // there are only I frames in backward
-  cMutexLock MutexLock(&mutex);
-  if (w == r || Pts == 0 && !Still) // while 0 is a valid PTS, DeviceGetSTC() might return 0 if, after a jump,  the device hasn't displayed a frame, yet
-     return lastFound; // replay always starts at an I frame
-  bool Valid = false;
-  int FrameNumber = 0;
-  int UnplayedIFrame = 2; // GOPs may intersect, so we loop until we processed a complete unplayed GOP
-  for (int i = r; i != w && UnplayedIFrame; ) {
-      int32_t d = int32_t(Pts - pi[i].pts); // typecast handles rollover
-      if (d >= 0) {
-         if (pi[i].independent) {
-            FrameNumber = pi[i].index; // an I frame's index represents its frame number
-            Valid = true;
-            if (d == 0)
-               UnplayedIFrame = 1; // if Pts is at an I frame we only need to check up to the next I frame
-            }
-         else
-            FrameNumber++; // for every played non-I frame, increase frame number
-         }
-      else if (pi[i].independent)
-         --UnplayedIFrame;
-      if (++i >= PTSINDEX_ENTRIES)
-         i = 0;
-      }
-  if (Valid) {
-     lastFound = FrameNumber;
-     return FrameNumber;
-     }
+  {
+    cMutexLock MutexLock(&mutex);
+    if (w == r || Pts == 0 && !Still) // while 0 is a valid PTS, DeviceGetSTC() might return 0 if, after a jump,  the device hasn't displayed a frame, yet
+       return lastFound; // replay always starts at an I frame
+    uint32_t NearestPts;
+    bool InRange;
+    FindNearest(Pts, NearestPts, InRange);
+    if (InRange) {
+       bool Valid = false;
+       int FrameNumber = 0;
+       int UnplayedIFrame = 2; // GOPs may intersect, so we loop until we processed a complete unplayed GOP
+       for (int i = r; i != w && UnplayedIFrame; ) {
+           int32_t d = int32_t(Pts - pi[i].pts); // typecast handles rollover
+           if (d >= 0) {
+              if (pi[i].independent) {
+                 FrameNumber = pi[i].index; // an I frame's index represents its frame number
+                 Valid = true;
+                 if (d == 0)
+                    UnplayedIFrame = 1; // if Pts is at an I frame we only need to check up to the next I frame
+                 }
+              else
+                 FrameNumber++; // for every played non-I frame, increase frame number
+              }
+           else if (pi[i].independent)
+              --UnplayedIFrame;
+           if (++i >= PTSINDEX_ENTRIES)
+              i = 0;
+           }
+       if (Valid) {
+          lastFound = FrameNumber;
+          return FrameNumber;
+          }
+       }
+  }
   return FindIndex(Pts, Still); // fall back during trick speeds
 }
 
+int cPtsIndex::SkipSeconds(int Index, int Seconds)
+{
+  uint32_t Pts;
+  if (GetFramePts(Index, Pts)) {
+     uint32_t FirstPts;
+     int First = index->GetNextIFrame(-1, true);
+     if (First >= 0 && GetPts(First, FirstPts)) {
+        Pts += Seconds * PTSTICKS;
+        if (uint32_t(Pts - FirstPts) >= PTSBEFORESTART)
+           return 0;
+        return Lookup(Pts);
+        }
+     }
+  return -1;
+}
+
 // --- cNonBlockingFileReader ------------------------------------------------
 
 class cNonBlockingFileReader : public cThread {
@@ -160,14 +445,14 @@ cNonBlockingFileReader::~cNonBlockingFileReader()
 {
   newSet.Signal();
   Cancel(3);
-  free(buffer);
+  cFramePool::Free(buffer);
 }
 
 void cNonBlockingFileReader::Clear(void)
 {
   Lock();
   f = NULL;
-  free(buffer);
+  cFramePool::Free(buffer);
   buffer = NULL;
   wanted = length = 0;
   Unlock();
@@ -178,7 +463,7 @@ void cNonBlockingFileReader::Request(cUnbufferedFile *File, int Length)
   Lock();
   Clear();
   wanted = Length;
-  buffer = MALLOC(uchar, wanted);
+  buffer = (uchar *)cFramePool::Alloc(wanted);
   f = File;
   Unlock();
   newSet.Signal();
@@ -236,6 +521,9 @@ bool cNonBlockingFileReader::WaitForDataMs(int msToWait)
 
 #define PLAYERBUFSIZE  (MAXFRAMESIZE * 5)
 
+#define PREFETCHSECONDS 2 // number of seconds to prefetch ahead of the current frame in normal replay
+#define PREFETCHIFRAMES 4 // number of I-frames to prefetch ahead of the current frame in trick modes
+
 #define RESUMEBACKUP 10 // number of seconds to back up when resuming an interrupted replay session
 #define MAXSTUCKATEOF 3 // max. number of seconds to wait in case the device doesn't play the last frame
 
@@ -260,6 +548,7 @@ private:
   ePlayDirs playDir;
   int trickSpeed;
   int readIndex;
+  int prefetchIndex;
   bool readIndependent;
   cFrame *readFrame;
   cFrame *playFrame;
@@ -267,6 +556,7 @@ private:
   bool resyncAfterPause;
   void TrickSpeed(int Increment);
   void Empty(void);
+  void Prefetch(void);
   bool NextFile(uint16_t FileNumber = 0, off_t FileOffset = -1);
   int Resume(void);
   bool Save(void);
@@ -316,6 +606,7 @@ cDvbPlayer::cDvbPlayer(const char *FileName, bool PauseLive)
   playDir = pdForward;
   trickSpeed = NORMAL_SPEED;
   readIndex = -1;
+  prefetchIndex = -1;
   readIndependent = false;
   readFrame = NULL;
   playFrame = NULL;
@@ -337,6 +628,7 @@ cDvbPlayer::cDvbPlayer(const char *FileName, bool PauseLive)
      }
   else if (PauseLive)
      framesPerSecond = cRecording(FileName).FramesPerSecond(); // the fps rate might have changed from the default
+  ptsIndex.SetIndex(index, FileName, isPesRecording, framesPerSecond);
 }
 
 cDvbPlayer::~cDvbPlayer()
@@ -390,6 +682,57 @@ void cDvbPlayer::Empty(void)
   ptsIndex.Clear();
   DeviceClear();
   firstPacket = true;
+  prefetchIndex = -1;
+}
+
+void cDvbPlayer::Prefetch(void)
+{
+  // Tells the file system which frames will be read after the one at readIndex,
+  // so that it can fetch them while the current ones are being played. This
+  // keeps trick modes smooth on slow (e.g. network mounted) video directories.
+  if (!index || !replayFile || readIndex < 0)
+     return;
+  uint16_t FileNumber;
+  off_t FileOffset;
+  int Length;
+  if ((playMode == pmFast || (playMode == pmSlow && playDir == pdBackward)) && !(DeviceHasIBPTrickSpeed() && playDir == pdForward)) {
+     // Only I-frames are read, so we prefetch the next ones in the current direction:
+     int Depth = playMode == pmFast ? PREFETCHIFRAMES * Speeds[trickSpeed] / 2 : PREFETCHIFRAMES;
+     int d = int(round(0.4 * framesPerSecond));
+     if (playDir != pdForward)
+        d = -d;
+     int Index = readIndex;
+     for (int i = 0; i < Depth; i++) {
+         if (Index + d <= 0)
+            break;
+         Index = index->GetNextIFrame(Index + d, playDir == pdForward, &FileNumber, &FileOffset, &Length);
+         if (Index < 0 || FileNumber != fileName->Number())
+            break;
+         if (prefetchIndex < 0 || (playDir == pdForward ? Index > prefetchIndex : Index < prefetchIndex)) {
+            replayFile->Prefetch(FileOffset, Length);
+            prefetchIndex = Index;
+            }
+         }
+     }
+  else if (playDir == pdForward) {
+     // All frames are read, so we prefetch the data of the next few seconds in
+     // one go whenever half of the previously prefetched data has been read:
+     int Frames = int(round(PREFETCHSECONDS * framesPerSecond));
+     if (playMode == pmFast)
+        Frames *= Speeds[trickSpeed];
+     if (prefetchIndex < readIndex + Frames / 2) {
+        int First = max(prefetchIndex, readIndex) + 1;
+        int Last = min(readIndex + Frames, index->Last());
+        uint16_t LastFileNumber;
+        off_t LastFileOffset;
+        if (Last >= First && index->Get(First, &FileNumber, &FileOffset) && index->Get(Last, &LastFileNumber, &LastFileOffset, NULL, &Length)) {
+           if (FileNumber == fileName->Number() && LastFileNumber == FileNumber && Length > 0) {
+              replayFile->Prefetch(FileOffset, LastFileOffset + Length - FileOffset);
+              prefetchIndex = Last;
+              }
+           }
+        }
+     }
 }
 
 bool cDvbPlayer::NextFile(uint16_t FileNumber, off_t FileOffset)
@@ -577,8 +920,10 @@ void cDvbPlayer::Action(void)
                       esyslog("ERROR: frame larger than buffer (%d > %d)", Length, MAXFRAMESIZE);
                       Length = MAXFRAMESIZE;
                       }
-                   if (!eof)
+                   if (!eof) {
+                      Prefetch(); // before the request, because cUnbufferedFile::Prefetch() must not be called while reading
                       nonBlockingFileReader->Request(replayFile, Length);
+                      }
                    }
                 if (!eof) {
                    uchar *b = NULL;
@@ -587,7 +932,7 @@ void cDvbPlayer::Action(void)
                       WaitingForData = false;
                       LastReadFrame = readIndex;
                       uint32_t Pts = isPesRecording ? (PesHasPts(b) ? PesGetPts(b) : -1) : TsGetPts(b, r);
-                      readFrame = new cFrame(b, -r, ftUnknown, readIndex, Pts, readIndependent); // hands over b to the ringBuffer
+                      readFrame = new cFrame(b, -r, ftUnknown, readIndex, Pts, readIndependent, true); // hands over b to the ringBuffer
                       }
                    else if (r < 0) {
                       if (errno == EAGAIN)
@@ -891,7 +1236,8 @@ void cDvbPlayer::SkipSeconds(int Seconds)
      int Index = ptsIndex.FindIndex(DeviceGetSTC(), playMode == pmStill);
      Empty();
      if (Index >= 0) {
-        Index = max(Index + SecondsToFrames(Seconds, framesPerSecond), 0);
+        int i = ptsIndex.SkipSeconds(Index, Seconds);
+        Index = i >= 0 ? i : max(Index + SecondsToFrames(Seconds, framesPerSecond), 0);
         if (Index > 0)
            Index = index->GetNextIFrame(Index, false, NULL, NULL, NULL);
         if (Index >= 0)
@@ -29,6 +29,7 @@
 //   event id for tables 0x4E and 0x5X.
 
 #include "eit.h"
+#include <inttypes.h>
 #include <sys/time.h>
 #include "epg.h"
 #include "i18n.h"
@@ -493,8 +494,18 @@ cTDT::cTDT(const u_char *Data)
 
 time_t cEitFilter::disableUntil = 0;
 
+static uint64_t MicroSeconds(void)
+{
+  struct timespec tp;
+  if (clock_gettime(CLOCK_MONOTONIC, &tp) == 0)
+     return uint64_t(tp.tv_sec) * 1000000 + tp.tv_nsec / 1000;
+  return 0;
+}
+
 cEitFilter::cEitFilter(void)
 {
+  sections = 0;
+  processingTime = 0;
   Set(0x12, 0x40, 0xC0);  // event info present&following actual/other TS (0x4E/0x4F), future actual/other TS (0x5X/0x6X)
   Set(0x14, 0x70);        // TDT
 }
@@ -511,6 +522,12 @@ void cEitFilter::SetDisableUntil(time_t Time)
   disableUntil = Time;
 }
 
+cString cEitFilter::Metrics(void)
+{
+  cMutexLock MutexLock(&mutex);
+  return cString::sprintf("eitsections=%d eittime=%" PRIu64, sections, processingTime);
+}
+
 void cEitFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length)
 {
   cMutexLock MutexLock(&mutex);
@@ -522,8 +539,12 @@ void cEitFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
      }
   switch (Pid) {
     case 0x12: {
-         if (Tid == 0x4E || Tid >= 0x50 && Tid <= 0x6F) // we ignore 0x4F, which only causes trouble
+         if (Tid == 0x4E || Tid >= 0x50 && Tid <= 0x6F) { // we ignore 0x4F, which only causes trouble
+            uint64_t Start = MicroSeconds();
             cEIT EIT(eitTablesHash, Source(), Tid, Data);
+            processingTime += MicroSeconds() - Start;
+            sections++;
+            }
          }
          break;
     case 0x14: {
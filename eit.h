@@ -49,6 +49,8 @@ class cEitFilter : public cFilter {
 private:
   cMutex mutex;
   cEitTablesHash eitTablesHash;
+  int sections; // the number of EIT sections processed
+  uint64_t processingTime; // the time spent processing them (in microseconds)
   static time_t disableUntil;
 protected:
   virtual void Process(u_short Pid, u_char Tid, const u_char *Data, int Length) override;
@@ -56,6 +58,11 @@ public:
   cEitFilter(void);
   virtual void SetStatus(bool On) override;
   static void SetDisableUntil(time_t Time);
+  cString Metrics(void);
+       ///< Returns the number of EIT sections this filter has processed and the time
+       ///< (in microseconds) it has spent on them, in the form "key=value key=value".
+       ///< Replaying a recorded stream with the --tsfile option allows measuring the
+       ///< EIT processing rate this way.
   };
 
 #endif //__EIT_H
@@ -12,12 +12,15 @@
 
 #include "epg.h"
 #include <ctype.h>
+#include <inttypes.h>
 #include <limits.h>
+#include <sys/mman.h>
 #include <time.h>
 #include "libsi/si.h"
 
 #define RUNNINGSTATUSTIMEOUT 30 // seconds before the running status is considered unknown
 #define EPGDATAWRITEDELTA   600 // seconds between writing the epg.data file
+#define EPGJOURNALEXT       ".journal"
 
 // --- tComponent ------------------------------------------------------------
 
@@ -108,6 +111,144 @@ tComponent *cComponents::GetComponent(int Index, uchar Stream, uchar Type)
   return NULL;
 }
 
+// --- cStringPool ----------------------------------------------------------
+
+// The texts of events are kept in a pool, so that identical strings are only
+// stored once. Each string has a reference count and is deleted when the last
+// event using it releases it.
+
+class cStringPool {
+private:
+  struct tEntry {
+    tEntry *next;
+    unsigned int hash;
+    int refs;
+    int length;
+    char s[1];
+    };
+  cMutex mutex;
+  tEntry **table;
+  int size;
+  int count;
+  int64_t refs;
+  int64_t bytes;
+  int64_t refBytes;
+  static unsigned int Hash(const char *s, int &Length);
+  void Grow(void);
+public:
+  cStringPool(void);
+  const char *Get(const char *s);
+       ///< Returns a pooled copy of the given string, or NULL if s is NULL.
+  void Put(const char *s);
+       ///< Releases the given string, which must have been returned by Get().
+       ///< s may be NULL.
+  cString Metrics(void);
+  };
+
+cStringPool::cStringPool(void)
+{
+  size = 1024;
+  table = (tEntry **)calloc(size, sizeof(tEntry *));
+  count = 0;
+  refs = 0;
+  bytes = 0;
+  refBytes = 0;
+}
+
+unsigned int cStringPool::Hash(const char *s, int &Length)
+{
+  // FNV-1a
+  unsigned int h = 2166136261U;
+  const char *p = s;
+  for (; *p; p++)
+      h = (h ^ uchar(*p)) * 16777619U;
+  Length = p - s;
+  return h;
+}
+
+void cStringPool::Grow(void)
+{
+  int NewSize = size * 2;
+  if (tEntry **NewTable = (tEntry **)calloc(NewSize, sizeof(tEntry *))) {
+     for (int i = 0; i < size; i++) {
+         while (tEntry *e = table[i]) {
+               table[i] = e->next;
+               e->next = NewTable[e->hash % NewSize];
+               NewTable[e->hash % NewSize] = e;
+               }
+         }
+     free(table);
+     table = NewTable;
+     size = NewSize;
+     }
+}
+
+const char *cStringPool::Get(const char *s)
+{
+  if (!s)
+     return NULL;
+  int Length;
+  unsigned int h = Hash(s, Length);
+  cMutexLock MutexLock(&mutex);
+  tEntry *e = table[h % size];
+  while (e && !(e->hash == h && e->length == Length && memcmp(e->s, s, Length) == 0))
+        e = e->next;
+  if (!e) {
+     if (count >= size)
+        Grow();
+     e = (tEntry *)malloc(offsetof(tEntry, s) + Length + 1);
+     if (!e) {
+        esyslog("ERROR: out of memory");
+        return NULL;
+        }
+     e->hash = h;
+     e->refs = 0;
+     e->length = Length;
+     memcpy(e->s, s, Length + 1);
+     e->next = table[h % size];
+     table[h % size] = e;
+     count++;
+     bytes += Length + 1;
+     }
+  e->refs++;
+  refs++;
+  refBytes += Length + 1;
+  return e->s;
+}
+
+void cStringPool::Put(const char *s)
+{
+  if (!s)
+     return;
+  tEntry *e = (tEntry *)(s - offsetof(tEntry, s));
+  cMutexLock MutexLock(&mutex);
+  refs--;
+  refBytes -= e->length + 1;
+  if (--e->refs == 0) {
+     for (tEntry **p = &table[e->hash % size]; *p; p = &(*p)->next) {
+         if (*p == e) {
+            *p = e->next;
+            break;
+            }
+         }
+     count--;
+     bytes -= e->length + 1;
+     free(e);
+     }
+}
+
+cString cStringPool::Metrics(void)
+{
+  cMutexLock MutexLock(&mutex);
+  return cString::sprintf("texts=%d refs=%" PRId64 " bytes=%" PRId64 " saved=%" PRId64, count, refs, bytes, refBytes - bytes);
+}
+
+static cStringPool *EventTexts(void)
+{
+  static cStringPool *StringPool = new cStringPool; // never deleted, since events may still be destroyed while the program exits
+  return StringPool;
+}
+
 // --- cEvent ----------------------------------------------------------------
 
 cMutex cEvent::numTimersMutex;
@@ -136,9 +277,9 @@ cEvent::cEvent(tEventID EventID)
 
 cEvent::~cEvent()
 {
-  free(title);
-  free(shortText);
-  free(description);
+  EventTexts()->Put(title);
+  EventTexts()->Put(shortText);
+  EventTexts()->Put(description);
   free(aux);
   delete components;
 }
@@ -192,17 +333,23 @@ void cEvent::SetLanguage(const char *Language)
 
 void cEvent::SetTitle(const char *Title)
 {
-  title = strcpyrealloc(title, Title);
+  const char *OldTitle = title;
+  title = (char *)EventTexts()->Get(Title);
+  EventTexts()->Put(OldTitle);
 }
 
 void cEvent::SetShortText(const char *ShortText)
 {
-  shortText = strcpyrealloc(shortText, ShortText);
+  const char *OldShortText = shortText;
+  shortText = (char *)EventTexts()->Get(ShortText);
+  EventTexts()->Put(OldShortText);
 }
 
 void cEvent::SetDescription(const char *Description)
 {
-  description = strcpyrealloc(description, Description);
+  const char *OldDescription = description;
+  description = (char *)EventTexts()->Get(Description);
+  EventTexts()->Put(OldDescription);
 }
 
 void cEvent::SetComponents(cComponents *Components)
@@ -466,9 +613,16 @@ void cEvent::Dump(FILE *f, const char *Prefix, bool InfoOnly) const
      if (!isempty(shortText))
         fprintf(f, "%sS %s\n", Prefix, shortText);
      if (!isempty(description)) {
-        strreplace(description, '\n', '|');
-        fprintf(f, "%sD %s\n", Prefix, description);
-        strreplace(description, '|', '\n');
+        // the description is shared with other events, so it must not be modified here:
+        fprintf(f, "%sD ", Prefix);
+        for (const char *p = description; *p; ) {
+            const char *e = strchrnul(p, '\n');
+            fwrite(p, 1, e - p, f);
+            if (*e)
+               fputc('|', f);
+            p = *e ? e + 1 : e;
+            }
+        fputc('\n', f);
         }
      if (contents[0]) {
         fprintf(f, "%sG", Prefix);
@@ -707,6 +861,41 @@ static void StripControlCharacters(char *s)
 
 void cEvent::FixEpgBugs(void)
 {
+  // The texts are shared with other events, so the fixes are done on private copies:
+  char *Title = title ? strdup(title) : NULL;
+  char *ShortText = shortText ? strdup(shortText) : NULL;
+  char *Description = description ? strdup(description) : NULL;
+  // The pooled texts are released only after getting the fixed ones, so that an unchanged
+  // text that is used by this event only doesn't get freed and allocated again:
+  const char *OldTitle = title;
+  const char *OldShortText = shortText;
+  const char *OldDescription = description;
+  title = Title;
+  shortText = ShortText;
+  description = Description;
+  DoFixEpgBugs();
+  Title = title;
+  ShortText = shortText;
+  Description = description;
+  title = (char *)EventTexts()->Get(Title);
+  shortText = (char *)EventTexts()->Get(ShortText);
+  description = (char *)EventTexts()->Get(Description);
+  EventTexts()->Put(OldTitle);
+  EventTexts()->Put(OldShortText);
+  EventTexts()->Put(OldDescription);
+  free(Title);
+  free(ShortText);
+  free(Description);
+}
+
+cString cEvent::Metrics(void)
+{
+  return EventTexts()->Metrics();
+}
+
+void cEvent::DoFixEpgBugs(void)
+{
+  // Works on private copies of title, shortText and description (see FixEpgBugs()).
   if (isempty(title)) {
      // we don't want any "(null)" titles
      title = strcpyrealloc(title, tr("No title"));
@@ -947,6 +1136,7 @@ cSchedule::cSchedule(tChannelID ChannelID)
   events.SetUseGarbageCollector();
   numTimers = 0;
   modified = 0;
+  saved = 0;
   onActualTp = false;
   presentSeen = 0;
 }
@@ -996,6 +1186,20 @@ void cSchedule::DelEvent(cEvent *Event)
      }
 }
 
+int cSchedule::FindEventAfter(time_t Time) const
+{
+  int l = 0;
+  int h = eventsByTime.Size();
+  while (l < h) {
+        int m = (l + h) / 2;
+        if (eventsByTime[m]->StartTime() <= Time)
+           l = m + 1;
+        else
+           h = m;
+        }
+  return l;
+}
+
 void cSchedule::HashEvent(cEvent *Event)
 {
   if (cEvent *p = eventsHashID.Get(Event->EventID()))
@@ -1006,6 +1210,12 @@ void cSchedule::HashEvent(cEvent *Event)
         eventsHashStartTime.Del(p, p->StartTime());
      eventsHashStartTime.Add(Event, Event->StartTime());
      }
+  int i = FindEventAfter(Event->StartTime());
+  for (int j = i - 1; j >= 0 && eventsByTime[j]->StartTime() == Event->StartTime(); j--) {
+      if (eventsByTime[j] == Event)
+         return;
+      }
+  eventsByTime.Insert(Event, i);
 }
 
 void cSchedule::UnhashEvent(cEvent *Event)
@@ -1013,21 +1223,27 @@ void cSchedule::UnhashEvent(cEvent *Event)
   eventsHashID.Del(Event, Event->EventID());
   if (Event->StartTime() > 0) // 'StartTime < 0' is apparently used with NVOD channels
      eventsHashStartTime.Del(Event, Event->StartTime());
+  for (int i = FindEventAfter(Event->StartTime()) - 1; i >= 0 && eventsByTime[i]->StartTime() == Event->StartTime(); i--) {
+      if (eventsByTime[i] == Event) {
+         eventsByTime.Remove(i);
+         break;
+         }
+      }
 }
 
 const cEvent *cSchedule::GetPresentEvent(void) const
 {
-  const cEvent *pe = NULL;
   time_t now = time(NULL);
-  for (const cEvent *p = events.First(); p; p = events.Next(p)) {
-      if (p->StartTime() <= now)
-         pe = p;
-      else if (p->StartTime() > now + 3600)
-         break;
+  int Present = FindEventAfter(now); // the present event is the one before this
+  int Last = FindEventAfter(now + 3600);
+  // An event that is actually running has precedence (outdated events are removed by
+  // Cleanup(), so this only checks very few events before the present one):
+  for (int i = 0; i < Last; i++) {
+      const cEvent *p = eventsByTime[i];
       if (p->SeenWithin(RUNNINGSTATUSTIMEOUT) && p->RunningStatus() >= SI::RunningStatusPausing)
          return p;
       }
-  return pe;
+  return Present > 0 ? eventsByTime[Present - 1] : NULL;
 }
 
 const cEvent *cSchedule::GetFollowingEvent(void) const
@@ -1036,11 +1252,8 @@ const cEvent *cSchedule::GetFollowingEvent(void) const
   if (p)
      p = events.Next(p);
   else {
-     time_t now = time(NULL);
-     for (p = events.First(); p; p = events.Next(p)) {
-         if (p->StartTime() >= now)
-            break;
-         }
+     int i = FindEventAfter(time(NULL) - 1); // the first event that starts at or after now
+     p = i < eventsByTime.Size() ? eventsByTime[i] : NULL;
      }
   return p;
 }
@@ -1059,14 +1272,15 @@ const cEvent *cSchedule::GetEventByTime(time_t StartTime) const
 
 const cEvent *cSchedule::GetEventAround(time_t Time) const
 {
+  // Find the event with the latest start time at or before Time that hasn't ended
+  // before Time (the first one, if several events have the same start time):
   const cEvent *pe = NULL;
-  time_t delta = INT_MAX;
-  for (const cEvent *p = events.First(); p; p = events.Next(p)) {
-      time_t dt = Time - p->StartTime();
-      if (dt >= 0 && dt < delta && p->EndTime() >= Time) {
-         delta = dt;
+  for (int i = FindEventAfter(Time) - 1; i >= 0; i--) {
+      const cEvent *p = eventsByTime[i];
+      if (pe && p->StartTime() != pe->StartTime())
+         break;
+      if (Time - p->StartTime() < INT_MAX && p->EndTime() >= Time)
          pe = p;
-         }
       }
   return pe;
 }
@@ -1196,7 +1410,7 @@ void cSchedule::Dump(const cChannels *Channels, FILE *f, const char *Prefix, eDu
      }
 }
 
-bool cSchedule::Read(FILE *f, cSchedules *Schedules)
+bool cSchedule::Read(FILE *f, cSchedules *Schedules, bool Replace)
 {
   if (Schedules) {
      int Line = 0;
@@ -1213,6 +1427,26 @@ bool cSchedule::Read(FILE *f, cSchedules *Schedules)
                  tChannelID channelID = tChannelID::FromString(s);
                  if (channelID.Valid()) {
                     if (cSchedule *p = Schedules->AddSchedule(channelID)) {
+                       if (Replace) {
+                          // The events are only replaced if the whole block can be read, so that
+                          // an incompletely written block doesn't delete any of them:
+                          long Pos = ftell(f);
+                          int BlockLine = Line;
+                          cSchedule Block(channelID);
+                          if (Pos < 0 || !cEvent::Read(f, &Block, Line))
+                             return false;
+                          if (fseek(f, Pos, SEEK_SET) < 0) {
+                             LOG_ERROR;
+                             return false;
+                             }
+                          Line = BlockLine;
+                          for (cEvent *Event = p->events.First(); Event; ) {
+                              cEvent *Next = p->events.Next(Event);
+                              if (!Event->HasTimer())
+                                 p->DelEvent(Event);
+                              Event = Next;
+                              }
+                          }
                        if (!cEvent::Read(f, p, Line))
                           return false;
                        p->Sort();
@@ -1245,7 +1479,7 @@ protected:
 public:
   cEpgDataWriter(void);
   void SetDump(bool Dump) { dump = Dump; }
-  void Perform(void);
+  void Perform(bool Incremental = false);
   };
 
 cEpgDataWriter::cEpgDataWriter(void)
@@ -1256,10 +1490,10 @@ cEpgDataWriter::cEpgDataWriter(void)
 
 void cEpgDataWriter::Action(void)
 {
-  Perform();
+  Perform(Setup.EPGIncrementalSave);
 }
 
-void cEpgDataWriter::Perform(void)
+void cEpgDataWriter::Perform(bool Incremental)
 {
   cMutexLock MutexLock(&mutex); // to make sure fore- and background calls don't cause parellel dumps!
   {
@@ -1271,12 +1505,195 @@ void cEpgDataWriter::Perform(void)
        StateKey.Remove();
        }
   }
-  if (dump)
-     cSchedules::Dump();
+  if (dump) {
+     if (Incremental)
+        cSchedules::DumpJournal();
+     else
+        cSchedules::Dump();
+     }
 }
 
 static cEpgDataWriter EpgDataWriter;
 
+// --- EPG data snapshot -----------------------------------------------------
+
+// The binary EPG data snapshot starts with a tEpgSnapshotHeader, followed by a
+// tEpgSnapshotSchedule for each schedule, each of which is immediately followed
+// by a tEpgSnapshotEvent for each of its events. An event record contains its
+// tEpgSnapshotComponents and the 0-terminated strings for title, short text,
+// description, aux and the component descriptions (in this sequence, empty
+// strings for missing ones), and is padded to a multiple of 8 bytes. All values
+// are stored in host byte order, so that the file can be used directly through
+// mmap(). If anything in the layout changes, EPGSNAPSHOTVERSION must be increased.
+
+#define EPGSNAPSHOTMAGIC   "VDR-EPG" // the terminating 0 is part of the magic
+#define EPGSNAPSHOTVERSION 1
+#define EPGSNAPSHOTBOM     0x01020304 // detects a file written on a machine with different byte order
+#define EPGSNAPSHOTALIGN   8
+
+struct tEpgSnapshotHeader {
+  char magic[sizeof(EPGSNAPSHOTMAGIC)];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t numSchedules;
+  uint32_t reserved;
+  };
+
+struct tEpgSnapshotSchedule {
+  int32_t source;
+  int32_t nid;
+  int32_t tid;
+  int32_t sid;
+  uint32_t numEvents;
+  uint32_t reserved;
+  };
+
+struct tEpgSnapshotEvent {
+  uint32_t size; // total size of this record, including components, strings and padding
+  uint32_t eventID;
+  int64_t startTime;
+  int64_t vps;
+  int32_t duration;
+  uint16_t numComponents;
+  uchar tableID;
+  uchar version;
+  uchar parentalRating;
+  uchar contents[MaxEventContents];
+  char language[MAXLANGCODE1];
+  uchar reserved[3];
+  };
+
+struct tEpgSnapshotComponent {
+  uchar stream;
+  uchar type;
+  char language[MAXLANGCODE2];
+  };
+
+static bool IsEpgSnapshot(FILE *f)
+{
+  char Magic[sizeof(EPGSNAPSHOTMAGIC)];
+  bool Result = fread(Magic, sizeof(Magic), 1, f) == 1 && memcmp(Magic, EPGSNAPSHOTMAGIC, sizeof(Magic)) == 0;
+  rewind(f);
+  return Result;
+}
+
+static const char *NextSnapshotString(const char *&s, const char *End)
+{
+  // the caller has made sure that End[-1] is 0, so strlen() can't go beyond End
+  if (s >= End)
+     return NULL;
+  const char *p = s;
+  s += strlen(s) + 1;
+  return p;
+}
+
+static void WriteSnapshotEvent(FILE *f, const cEvent *Event)
+{
+  static const char Padding[EPGSNAPSHOTALIGN] = { 0 };
+  const cComponents *Components = Event->Components();
+  int NumComponents = Components ? min(Components->NumComponents(), 0xFFFF) : 0;
+  const char *Strings[] = { Event->Title(), Event->ShortText(), Event->Description(), Event->Aux() };
+  size_t Size = sizeof(tEpgSnapshotEvent) + NumComponents * sizeof(tEpgSnapshotComponent);
+  for (size_t i = 0; i < sizeof(Strings) / sizeof(Strings[0]); i++)
+      Size += strlen(Strings[i] ? Strings[i] : "") + 1;
+  for (int i = 0; i < NumComponents; i++) {
+      const char *d = Components->Component(i)->description;
+      Size += strlen(d ? d : "") + 1;
+      }
+  size_t Padded = (Size + EPGSNAPSHOTALIGN - 1) & ~(EPGSNAPSHOTALIGN - 1);
+  tEpgSnapshotEvent e;
+  memset(&e, 0, sizeof(e));
+  e.size = Padded;
+  e.eventID = Event->EventID();
+  e.startTime = Event->StartTime();
+  e.vps = Event->Vps();
+  e.duration = Event->Duration();
+  e.numComponents = NumComponents;
+  e.tableID = Event->TableID();
+  e.version = Event->Version();
+  e.parentalRating = Event->ParentalRating();
+  for (int i = 0; i < MaxEventContents; i++)
+      e.contents[i] = Event->Contents(i);
+  strn0cpy(e.language, Event->Language(), sizeof(e.language));
+  fwrite(&e, sizeof(e), 1, f);
+  for (int i = 0; i < NumComponents; i++) {
+      const tComponent *p = Components->Component(i);
+      tEpgSnapshotComponent c;
+      memset(&c, 0, sizeof(c));
+      c.stream = p->stream;
+      c.type = p->type;
+      strn0cpy(c.language, p->language, sizeof(c.language));
+      fwrite(&c, sizeof(c), 1, f);
+      }
+  for (size_t i = 0; i < sizeof(Strings) / sizeof(Strings[0]); i++) {
+      const char *s = Strings[i] ? Strings[i] : "";
+      fwrite(s, strlen(s) + 1, 1, f);
+      }
+  for (int i = 0; i < NumComponents; i++) {
+      const char *d = Components->Component(i)->description;
+      d = d ? d : "";
+      fwrite(d, strlen(d) + 1, 1, f);
+      }
+  if (Padded > Size)
+     fwrite(Padding, Padded - Size, 1, f);
+}
+
+static void WriteSnapshotSchedule(FILE *f, const cSchedule *Schedule, time_t Now)
+{
+  tEpgSnapshotSchedule s;
+  memset(&s, 0, sizeof(s));
+  s.source = Schedule->ChannelID().Source();
+  s.nid = Schedule->ChannelID().Nid();
+  s.tid = Schedule->ChannelID().Tid();
+  s.sid = Schedule->ChannelID().Sid();
+  for (const cEvent *Event = Schedule->Events()->First(); Event; Event = Schedule->Events()->Next(Event)) {
+      if (Event->EndTime() + EPG_LINGER_TIME >= Now) // same criteria as in cEvent::Dump()
+         s.numEvents++;
+      }
+  fwrite(&s, sizeof(s), 1, f);
+  for (const cEvent *Event = Schedule->Events()->First(); Event; Event = Schedule->Events()->Next(Event)) {
+      if (Event->EndTime() + EPG_LINGER_TIME >= Now)
+         WriteSnapshotEvent(f, Event);
+      }
+}
+
+// --- EPG data journal ------------------------------------------------------
+
+// The journal of the EPG data file contains complete schedules in the textual
+// format, each of which replaces the events of that schedule that have been read
+// from the EPG data file (or from earlier parts of the journal). Its first line
+// identifies the generation of the EPG data file it applies to, so that a journal
+// that is left over from before that file was last written completely is ignored.
+
+static cString EpgJournalFileName(const char *EpgDataFileName)
+{
+  return cString::sprintf("%s%s", EpgDataFileName, EPGJOURNALEXT);
+}
+
+static cString EpgDataGeneration(const char *EpgDataFileName)
+{
+  // The EPG data file is always written as a new file (see cSafeFile), so its
+  // inode, size and modification time change with every generation:
+  struct stat st;
+  if (stat(EpgDataFileName, &st) == 0)
+     return cString::sprintf("G %ju %jd %jd", uintmax_t(st.st_ino), intmax_t(st.st_size), intmax_t(st.st_mtime));
+  return NULL;
+}
+
+static bool EpgJournalGenerationOk(FILE *f, const char *Generation)
+{
+  cReadLine ReadLine;
+  const char *s = ReadLine.Read(f);
+  return s && Generation && strcmp(s, Generation) == 0;
+}
+
+static void RemoveEpgJournal(const char *EpgDataFileName)
+{
+  cString FileName = EpgJournalFileName(EpgDataFileName);
+  if (unlink(FileName) < 0 && errno != ENOENT)
+     LOG_ERROR_STR(*FileName);
+}
+
 // --- cSchedules ------------------------------------------------------------
 
 cSchedules cSchedules::schedules;
@@ -1286,6 +1703,7 @@ time_t cSchedules::lastDump = time(NULL);
 cSchedules::cSchedules(void)
 :cList<cSchedule>("5 Schedules")
 {
+  numHashed = 0;
 }
 
 const cSchedules *cSchedules::GetSchedulesRead(cStateKey &StateKey, int TimeoutMs)
@@ -1328,31 +1746,125 @@ void cSchedules::ResetVersions(void)
 
 bool cSchedules::Dump(FILE *f, const char *Prefix, eDumpMode DumpMode, time_t AtTime)
 {
-  cSafeFile *sf = NULL;
-  if (!f) {
-     sf = new cSafeFile(epgDataFileName);
-     if (sf->Open())
-        f = *sf;
-     else {
-        LOG_ERROR;
-        delete sf;
-        return false;
-        }
-     }
+  if (!f)
+     return DumpDataFile();
   LOCK_CHANNELS_READ;
   LOCK_SCHEDULES_READ;
   for (const cSchedule *p = Schedules->First(); p; p = Schedules->Next(p))
       p->Dump(Channels, f, Prefix, DumpMode, AtTime);
-  if (sf) {
-     sf->Close();
-     delete sf;
+  return true;
+}
+
+int cSchedules::DumpSchedules(FILE *f, bool Snapshot, bool ModifiedOnly, cVector<const cSchedule *> &Written, cVector<int> &Versions)
+{
+  time_t Now = time(NULL);
+  long Start = ftell(f);
+  int NumSchedules = 0;
+  const cSchedule *Schedule = NULL;
+  for (;;) {
+      // The lists are locked only while formatting a single schedule, so that
+      // EIT processing isn't stalled by writing the whole file:
+      char *Buffer = NULL;
+      size_t Size = 0;
+      {
+        LOCK_CHANNELS_READ;
+        LOCK_SCHEDULES_READ;
+        if (Schedule && !Schedules->Contains(Schedule)) {
+           if (ModifiedOnly)
+              break; // the rest will be written next time
+           // The file must contain all schedules, so it is written again from the start:
+           dsyslog("schedule deleted while writing EPG data - starting over");
+           if (fseek(f, Start, SEEK_SET) < 0 || ftruncate(fileno(f), Start) < 0) {
+              LOG_ERROR;
+              return -1;
+              }
+           Written.Clear();
+           Versions.Clear();
+           NumSchedules = 0;
+           Schedule = NULL;
+           }
+        Schedule = Schedule ? Schedules->Next(Schedule) : Schedules->First();
+        if (!Schedule)
+           break;
+        if (!ModifiedOnly || Schedule->modified != Schedule->saved) {
+           if (!Snapshot || Channels->GetByChannelID(Schedule->ChannelID(), true)) {
+              FILE *m = open_memstream(&Buffer, &Size);
+              if (!m) {
+                 LOG_ERROR;
+                 return -1;
+                 }
+              if (Snapshot)
+                 WriteSnapshotSchedule(m, Schedule, Now);
+              else
+                 Schedule->Dump(Channels, m);
+              fclose(m);
+              }
+           Written.Append(Schedule);
+           Versions.Append(Schedule->modified);
+           }
+      }
+      if (Buffer) {
+         bool Ok = !Size || fwrite(Buffer, Size, 1, f) == 1;
+         free(Buffer);
+         if (!Ok)
+            return -1;
+         if (Size)
+            NumSchedules++;
+         }
+      }
+  return ferror(f) ? -1 : NumSchedules;
+}
+
+void cSchedules::SetSaved(const cVector<const cSchedule *> &Written, const cVector<int> &Versions)
+{
+  LOCK_SCHEDULES_READ;
+  for (int i = 0; i < Written.Size(); i++) {
+      if (Schedules->Contains(Written[i]))
+         Written[i]->saved = Versions[i];
+      }
+}
+
+bool cSchedules::DumpDataFile(void)
+{
+  cSafeFile f(epgDataFileName);
+  if (!f.Open()) {
+     LOG_ERROR;
+     return false;
      }
+  bool Snapshot = Setup.EPGBinaryData;
+  tEpgSnapshotHeader Header;
+  if (Snapshot) {
+     memset(&Header, 0, sizeof(Header));
+     memcpy(Header.magic, EPGSNAPSHOTMAGIC, sizeof(Header.magic));
+     Header.version = EPGSNAPSHOTVERSION;
+     Header.byteOrder = EPGSNAPSHOTBOM;
+     fwrite(&Header, sizeof(Header), 1, f); // numSchedules is filled in below
+     }
+  cVector<const cSchedule *> Written;
+  cVector<int> Versions;
+  int NumSchedules = DumpSchedules(f, Snapshot, false, Written, Versions);
+  if (NumSchedules < 0) {
+     esyslog("ERROR: can't write EPG data file %s", epgDataFileName);
+     return false; // cSafeFile removes the incomplete file
+     }
+  if (Snapshot) {
+     Header.numSchedules = NumSchedules;
+     if (fseek(f, 0, SEEK_SET) < 0 || fwrite(&Header, sizeof(Header), 1, f) != 1) {
+        LOG_ERROR;
+        return false;
+        }
+     }
+  if (!f.Close())
+     return false;
+  SetSaved(Written, Versions);
+  RemoveEpgJournal(epgDataFileName);
   return true;
 }
 
 bool cSchedules::Read(FILE *f)
 {
   bool OwnFile = f == NULL;
+  cTimeMs Timer;
   if (OwnFile) {
      if (epgDataFileName && access(epgDataFileName, R_OK) == 0) {
         dsyslog("reading EPG data from %s", epgDataFileName);
@@ -1366,9 +1878,17 @@ bool cSchedules::Read(FILE *f)
      }
   LOCK_CHANNELS_WRITE;
   LOCK_SCHEDULES_WRITE;
-  bool result = cSchedule::Read(f, Schedules);
-  if (OwnFile)
+  bool Snapshot = OwnFile && IsEpgSnapshot(f);
+  bool result = Snapshot ? ReadSnapshot(f, Schedules) : cSchedule::Read(f, Schedules);
+  if (OwnFile) {
      fclose(f);
+     if (result && !ReadJournal(Schedules))
+        esyslog("ERROR: EPG data journal could not be read completely");
+     // What has just been read doesn't need to be written to the journal again:
+     for (const cSchedule *p = Schedules->First(); p; p = Schedules->Next(p))
+         p->Modified(p->saved);
+     dsyslog("read EPG data (%s format) in %d ms", Snapshot ? "snapshot" : "text", int(Timer.Elapsed()));
+     }
   if (result) {
      // Initialize the channels' schedule pointers, so that the first WhatsOn menu will come up faster:
      for (cChannel *Channel = Channels->First(); Channel; Channel = Channels->Next(Channel)) {
@@ -1382,6 +1902,195 @@ bool cSchedules::Read(FILE *f)
   return result;
 }
 
+bool cSchedules::ReadSnapshot(FILE *f, cSchedules *Schedules)
+{
+  struct stat st;
+  if (fstat(fileno(f), &st) < 0) {
+     LOG_ERROR;
+     return false;
+     }
+  size_t Size = st.st_size;
+  if (Size < sizeof(tEpgSnapshotHeader)) {
+     esyslog("ERROR: EPG data snapshot is too short");
+     return false;
+     }
+  const uchar *Data = (const uchar *)mmap(NULL, Size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+  if (Data == MAP_FAILED) {
+     LOG_ERROR;
+     return false;
+     }
+  madvise((void *)Data, Size, MADV_SEQUENTIAL);
+  bool Result = false;
+  const tEpgSnapshotHeader *Header = (const tEpgSnapshotHeader *)Data;
+  if (Header->byteOrder != EPGSNAPSHOTBOM)
+     esyslog("ERROR: EPG data snapshot has been written on a machine with different byte order");
+  else if (Header->version != EPGSNAPSHOTVERSION)
+     esyslog("ERROR: unsupported EPG data snapshot version %u", Header->version);
+  else {
+     size_t Offset = sizeof(tEpgSnapshotHeader);
+     uint32_t NumSchedules = 0;
+     for ( ; NumSchedules < Header->numSchedules; NumSchedules++) {
+         if (Size - Offset < sizeof(tEpgSnapshotSchedule))
+            break;
+         const tEpgSnapshotSchedule *s = (const tEpgSnapshotSchedule *)(Data + Offset);
+         Offset += sizeof(tEpgSnapshotSchedule);
+         tChannelID ChannelID(s->source, s->nid, s->tid, s->sid);
+         if (!ChannelID.Valid()) {
+            esyslog("ERROR: invalid channel ID in EPG data snapshot: %s", *ChannelID.ToString());
+            break;
+            }
+         cSchedule *Schedule = Schedules->AddSchedule(ChannelID);
+         uint32_t NumEvents = 0;
+         for ( ; NumEvents < s->numEvents; NumEvents++) {
+             if (Size - Offset < sizeof(tEpgSnapshotEvent))
+                break;
+             const tEpgSnapshotEvent *e = (const tEpgSnapshotEvent *)(Data + Offset);
+             if (e->size > Size - Offset || e->size % EPGSNAPSHOTALIGN || e->size < sizeof(tEpgSnapshotEvent) + e->numComponents * sizeof(tEpgSnapshotComponent) + 1)
+                break;
+             const tEpgSnapshotComponent *c = (const tEpgSnapshotComponent *)(e + 1);
+             const char *End = (const char *)e + e->size;
+             if (End[-1]) // strings and padding must be 0-terminated
+                break;
+             const char *p = (const char *)(c + e->numComponents);
+             const char *Title = NextSnapshotString(p, End);
+             const char *ShortText = NextSnapshotString(p, End);
+             const char *Description = NextSnapshotString(p, End);
+             const char *Aux = NextSnapshotString(p, End);
+             if (!Aux)
+                break;
+             cComponents *Components = NULL;
+             for (int i = 0; i < e->numComponents; i++) {
+                 const char *d = NextSnapshotString(p, End);
+                 if (!d)
+                    break;
+                 char Language[MAXLANGCODE2];
+                 strn0cpy(Language, c[i].language, sizeof(Language));
+                 if (!Components)
+                    Components = new cComponents;
+                 Components->SetComponent(i, c[i].stream, c[i].type, Language, d);
+                 }
+             if (e->numComponents && (!Components || Components->NumComponents() != e->numComponents)) {
+                delete Components;
+                break;
+                }
+             Offset += e->size;
+             // same as in cEvent::Read():
+             cEvent *Event = (cEvent *)Schedule->GetEventByTime(e->startTime);
+             cEvent *newEvent = NULL;
+             if (!Event) {
+                Event = newEvent = new cEvent(e->eventID);
+                Event->seen = 0;
+                }
+             Event->SetTableID(e->tableID); // e->version is ignored, just like with the textual format
+             Event->SetStartTime(e->startTime);
+             Event->SetDuration(e->duration);
+             if (newEvent)
+                Schedule->AddEvent(newEvent);
+             // The strings are taken directly from the mapped file:
+             Event->SetTitle(*Title ? Title : tr("No title"));
+             if (*ShortText)
+                Event->SetShortText(ShortText);
+             if (*Description)
+                Event->SetDescription(Description);
+             if (*Aux)
+                Event->SetAux(Aux);
+             uchar Contents[MaxEventContents];
+             memcpy(Contents, e->contents, sizeof(Contents));
+             Event->SetContents(Contents);
+             Event->SetParentalRating(e->parentalRating);
+             if (e->language[0]) {
+                char Language[MAXLANGCODE1];
+                strn0cpy(Language, e->language, sizeof(Language));
+                Event->SetLanguage(Language);
+                }
+             Event->SetComponents(Components);
+             Event->SetVps(e->vps);
+             }
+         Schedule->Sort();
+         if (NumEvents < s->numEvents)
+            break;
+         }
+     if (NumSchedules == Header->numSchedules)
+        Result = true;
+     else
+        esyslog("ERROR: EPG data snapshot is corrupted at offset %zu", Offset);
+     }
+  munmap((void *)Data, Size);
+  return Result;
+}
+
+bool cSchedules::DumpJournal(void)
+{
+  struct stat DataStat, JournalStat;
+  cString FileName = EpgJournalFileName(epgDataFileName);
+  if (stat(epgDataFileName, &DataStat) < 0)
+     return Dump(); // there is no EPG data file the journal could refer to
+  if (stat(FileName, &JournalStat) == 0 && JournalStat.st_size > DataStat.st_size / 2)
+     return Dump(); // compacts the journal into the EPG data file
+  cString Generation = EpgDataGeneration(epgDataFileName);
+  FILE *f = fopen(FileName, "a+");
+  if (!f) {
+     LOG_ERROR_STR(*FileName);
+     return false;
+     }
+  bool GenerationOk = EpgJournalGenerationOk(f, Generation);
+  fseek(f, 0, SEEK_END); // switches the stream from reading to writing
+  if (!GenerationOk) {
+     // This is a new journal, or one that doesn't belong to the current EPG data file:
+     if (ftruncate(fileno(f), 0) < 0) {
+        LOG_ERROR_STR(*FileName);
+        fclose(f);
+        return false;
+        }
+     fprintf(f, "%s\n", *Generation);
+     }
+  long JournalSize = ftell(f);
+  cVector<const cSchedule *> Written;
+  cVector<int> Versions;
+  int NumSchedules = DumpSchedules(f, false, true, Written, Versions);
+  bool Result = NumSchedules >= 0 && fflush(f) == 0 && fsync(fileno(f)) == 0 && !ferror(f);
+  if (!Result)
+     LOG_ERROR_STR(*FileName);
+  if (fclose(f) < 0) {
+     LOG_ERROR_STR(*FileName);
+     Result = false;
+     }
+  if (!Result) {
+     // The schedules will be written again next time, so any incompletely written
+     // one is removed to have the next ones appended properly:
+     if (JournalSize < 0 || truncate(FileName, JournalSize) < 0) {
+        LOG_ERROR_STR(*FileName);
+        return Dump();
+        }
+     return false;
+     }
+  SetSaved(Written, Versions);
+  if (NumSchedules)
+     dsyslog("wrote %d schedule%s to %s", NumSchedules, NumSchedules != 1 ? "s" : "", *FileName);
+  return Result;
+}
+
+bool cSchedules::ReadJournal(cSchedules *Schedules)
+{
+  cString FileName = EpgJournalFileName(epgDataFileName);
+  if (access(FileName, R_OK) == 0) {
+     if (FILE *f = fopen(FileName, "r")) {
+        bool Result = true;
+        if (EpgJournalGenerationOk(f, EpgDataGeneration(epgDataFileName))) {
+           dsyslog("reading EPG data journal from %s", *FileName);
+           Result = cSchedule::Read(f, Schedules, true);
+           }
+        else
+           isyslog("ignoring stale EPG data journal %s", *FileName);
+        fclose(f);
+        return Result;
+        }
+     LOG_ERROR_STR(*FileName);
+     return false;
+     }
+  return true;
+}
+
 cSchedule *cSchedules::AddSchedule(tChannelID ChannelID)
 {
   ChannelID.ClrRid();
@@ -1389,17 +2098,63 @@ cSchedule *cSchedules::AddSchedule(tChannelID ChannelID)
   if (!p) {
      p = new cSchedule(ChannelID);
      Add(p);
+     HashSchedule(p);
      }
   return p;
 }
 
+void cSchedules::HashSchedule(cSchedule *Schedule)
+{
+  schedulesHashSid.Add(Schedule, Schedule->ChannelID().Sid());
+  numHashed++;
+}
+
+void cSchedules::UnhashSchedule(cSchedule *Schedule)
+{
+  int Sid = Schedule->ChannelID().Sid();
+  if (cList<cHashObject> *list = schedulesHashSid.GetList(Sid)) {
+     for (cHashObject *hobj = list->First(); hobj; hobj = list->Next(hobj)) {
+         if (hobj->Object() == Schedule) { // it may have been added without AddSchedule()
+            schedulesHashSid.Del(Schedule, Sid);
+            numHashed--;
+            break;
+            }
+         }
+     }
+}
+
+void cSchedules::Del(cSchedule *Schedule, bool DeleteObject)
+{
+  UnhashSchedule(Schedule);
+  cList<cSchedule>::Del(Schedule, DeleteObject);
+}
+
+void cSchedules::Clear(void)
+{
+  schedulesHashSid.Clear();
+  numHashed = 0;
+  cList<cSchedule>::Clear();
+}
+
 const cSchedule *cSchedules::GetSchedule(tChannelID ChannelID) const
 {
   ChannelID.ClrRid();
-  for (const cSchedule *p = First(); p; p = Next(p)) {
-      if (p->ChannelID() == ChannelID)
-         return p;
-      }
+  int sid = ChannelID.Sid();
+  cList<cHashObject> *list = schedulesHashSid.GetList(sid);
+  if (list) {
+     for (cHashObject *hobj = list->First(); hobj; hobj = list->Next(hobj)) {
+         cSchedule *Schedule = (cSchedule *)hobj->Object();
+         if (Schedule->ChannelID() == ChannelID)
+            return Schedule;
+         }
+     }
+  if (Count() != numHashed) {
+     // Somebody has added a schedule without using AddSchedule():
+     for (const cSchedule *p = First(); p; p = Next(p)) {
+         if (p->ChannelID() == ChannelID)
+            return p;
+         }
+     }
   return NULL;
 }
 
@@ -1417,6 +2172,7 @@ const cSchedule *cSchedules::GetSchedule(const cChannel *Channel, bool AddIfMiss
   if (Channel->schedule == &DummySchedule && AddIfMissing) {
      cSchedule *Schedule = new cSchedule(Channel->GetChannelID());
      ((cSchedules *)this)->Add(Schedule);
+     ((cSchedules *)this)->HashSchedule(Schedule);
      Channel->schedule = Schedule;
      }
   return Channel->schedule != &DummySchedule? Channel->schedule : NULL;
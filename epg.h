@@ -72,6 +72,7 @@ typedef u_int32_t tEventID;
 
 class cEvent : public cListObject {
   friend class cSchedule;
+  friend class cSchedules;
 private:
   static cMutex numTimersMutex; // Protects numTimers, because it might be accessed from parallel read locks
   // The sequence of these parameters is optimized for minimal memory waste!
@@ -83,7 +84,7 @@ private:
   uchar runningStatus;     // 0=undefined, 1=not running, 2=starts in a few seconds, 3=pausing, 4=running
   uchar parentalRating;    // Parental rating of this event
   char language[MAXLANGCODE1]; // ISO 639-2/T three character language code of the language of title and shortText, 0 terminated!//XXX description?
-  char *title;             // Title of this event
+  char *title;             // Title of this event (shared with other events, see SetTitle())
   char *shortText;         // Short description of this event (typically the episode name in case of a series)
   char *description;       // Description of this event
   cComponents *components; // The stream components of this event
@@ -93,6 +94,7 @@ private:
   time_t vps;              // Video Programming Service timestamp (VPS, aka "Programme Identification Label", PIL)
   time_t seen;             // When this event was last seen in the data stream
   char *aux;               // Auxiliary data, for use with plugins
+  void DoFixEpgBugs(void);
 public:
   cEvent(tEventID EventID);
   ~cEvent();
@@ -133,6 +135,10 @@ public:
   void SetRunningStatus(int RunningStatus, const cChannel *Channel = NULL);
   void SetLanguage(const char *Language);
   void SetTitle(const char *Title);
+       ///< Sets the title of this event. Like the short text and the description,
+       ///< the title is kept in a pool of strings that is shared by all events, so
+       ///< that identical texts (as they occur with series, repeats and +1 channels)
+       ///< are stored only once.
   void SetShortText(const char *ShortText);
   void SetDescription(const char *Description);
   void SetComponents(cComponents *Components); // Will take ownership of Components!
@@ -148,21 +154,31 @@ public:
   bool Parse(char *s);
   static bool Read(FILE *f, cSchedule *Schedule, int &Line);
   void FixEpgBugs(void);
+  static cString Metrics(void);
+       ///< Returns the number of distinct texts in the pool of event texts, the number
+       ///< of references to them, the number of bytes they occupy and how many bytes
+       ///< are saved by sharing them, in the form "key=value key=value...".
   };
 
 class cSchedules;
 
 class cSchedule : public cListObject  {
+  friend class cSchedules;
 private:
   static cMutex numTimersMutex; // Protects numTimers, because it might be accessed from parallel read locks
   tChannelID channelID;
   cList<cEvent> events;
   cHash<cEvent> eventsHashID;
   cHash<cEvent> eventsHashStartTime;
+  cVector<cEvent *> eventsByTime; // all events, sorted by start time
   mutable u_int16_t numTimers;// The number of timers that use this schedule
   bool onActualTp;
   int modified;
+  mutable int saved; // the value of 'modified' when this schedule was last written to the EPG data file
   time_t presentSeen;
+  int FindEventAfter(time_t Time) const;
+       ///< Returns the index in eventsByTime of the first event that starts after
+       ///< the given Time (eventsByTime.Size() if there is none).
 public:
   cSchedule(tChannelID ChannelID);
   tChannelID ChannelID(void) const { return channelID; }
@@ -193,7 +209,12 @@ public:
   const cEvent *GetEventByTime(time_t StartTime) const;
   const cEvent *GetEventAround(time_t Time) const;
   void Dump(const cChannels *Channels, FILE *f, const char *Prefix = "", eDumpMode DumpMode = dmAll, time_t AtTime = 0) const;
-  static bool Read(FILE *f, cSchedules *Schedules);
+  static bool Read(FILE *f, cSchedules *Schedules, bool Replace = false);
+       ///< Reads schedules from the given file f and adds them to Schedules.
+       ///< If Replace is true, the events of a schedule that are already in
+       ///< Schedules are deleted before reading the new ones (except for events
+       ///< that have timers). This is only done once a schedule's block has been
+       ///< read completely, so f must be seekable in that case.
   };
 
 class cSchedules : public cList<cSchedule> {
@@ -202,6 +223,31 @@ private:
   static cSchedules schedules;
   static char *epgDataFileName;
   static time_t lastDump;
+  cHash<cSchedule> schedulesHashSid;
+  int numHashed; // the number of schedules in schedulesHashSid
+  void HashSchedule(cSchedule *Schedule);
+  void UnhashSchedule(cSchedule *Schedule);
+  static int DumpSchedules(FILE *f, bool Snapshot, bool ModifiedOnly, cVector<const cSchedule *> &Written, cVector<int> &Versions);
+      ///< Writes the schedules into the given file f, in the binary snapshot format
+      ///< (see epg.c) if Snapshot is true, otherwise in the textual format. If
+      ///< ModifiedOnly is true, only schedules that have been modified since they
+      ///< were last saved are written. The lists of channels and schedules are
+      ///< locked only while a single schedule is being formatted, and are never
+      ///< locked while writing to f. The handled schedules and their versions are
+      ///< returned in Written and Versions, to be given to SetSaved() once f has
+      ///< been written successfully.
+      ///< Returns the number of schedules written, or -1 in case of an error.
+  static void SetSaved(const cVector<const cSchedule *> &Written, const cVector<int> &Versions);
+      ///< Marks the given schedules as saved, as returned by DumpSchedules().
+  static bool DumpDataFile(void);
+      ///< Writes all schedules into the EPG data file, in the binary snapshot
+      ///< format if Setup.EPGBinaryData is set, and removes the journal.
+  static bool ReadSnapshot(FILE *f, cSchedules *Schedules);
+      ///< Reads a binary snapshot of all schedules, as written by DumpDataFile(),
+      ///< from the given file.
+  static bool ReadJournal(cSchedules *Schedules);
+      ///< Reads the schedules that have been written by DumpJournal() since the
+      ///< EPG data file has last been written completely.
 public:
   cSchedules(void);
   static const cSchedules *GetSchedulesRead(cStateKey &StateKey, int TimeoutMs = 0);
@@ -214,8 +260,30 @@ public:
   static void Cleanup(bool Force = false);
   static void ResetVersions(void);
   static bool Dump(FILE *f = NULL, const char *Prefix = "", eDumpMode DumpMode = dmAll, time_t AtTime = 0);
+      ///< Writes the schedules into the given file f in the textual format.
+      ///< If no file is given, the EPG data file is written, which is done in
+      ///< the binary snapshot format if Setup.EPGBinaryData is set, and any
+      ///< journal written by DumpJournal() is removed. In that case the lists of
+      ///< channels and schedules are locked only while a single schedule is being
+      ///< formatted.
+  static bool DumpJournal(void);
+      ///< Appends all schedules that have been modified since they were last
+      ///< written to the journal of the EPG data file (the EPG data file name with
+      ///< ".journal" appended). The lists of channels and schedules are locked only
+      ///< while a single schedule is being formatted, and are never locked while
+      ///< writing to the file. A schedule is only marked as saved once the journal
+      ///< has been written successfully. If the journal has grown larger than half
+      ///< the size of the EPG data file, Dump() is called instead to compact it.
   static bool Read(FILE *f = NULL);
+      ///< Reads the schedules from the given file f, which must be in the textual
+      ///< format. If no file is given, the EPG data file is read, which may be
+      ///< either in the textual or in the binary snapshot format, followed by
+      ///< its journal (if any).
   cSchedule *AddSchedule(tChannelID ChannelID);
+  void Del(cSchedule *Schedule, bool DeleteObject = true);
+       ///< Deletes the given Schedule from the list (and from the hash used by
+       ///< GetSchedule()).
+  virtual void Clear(void) override;
   const cSchedule *GetSchedule(tChannelID ChannelID) const;
   const cSchedule *GetSchedule(const cChannel *Channel, bool AddIfMissing = false) const;
   };
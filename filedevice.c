@@ -0,0 +1,615 @@
+/*
+ * filedevice.c: A device that reads a Transport Stream from a file
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#include "filedevice.h"
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "libsi/section.h"
+
+#define TSFILECHUNK     (100 * TS_SIZE) // the amount of data read from the file at once
+#define TSFILEPIPESIZE  MEGABYTE(1) // the size of the pipe that emulates the DVR device
+#define TSFILEBUFSIZE   MEGABYTE(4) // the size of the TS buffer reading from that pipe
+#define TSFILESCANSIZE  MEGABYTE(16) // the maximum amount of data to scan for the PAT and SDT
+#define MAXPCRJUMP      2000 // ms; larger PCR jumps are considered a discontinuity
+#define OVERFLOWREPORTDELTA 5 // seconds between reports of DVR buffer overflows
+#define SDTPID          0x0011 // the PID of the SDT
+
+// --- cSectionAssembler -----------------------------------------------------
+
+// Collects the sections of one PID from a sequence of TS packets.
+
+class cSectionAssembler {
+private:
+  uchar buffer[4096 + TS_SIZE]; // 4096 is the max. size of any section
+  int length;
+  bool synced;
+  int counter;
+  void Append(const uchar *Data, int Length);
+protected:
+  virtual void Section(const uchar *Data, int Length) = 0;
+       ///< Is called for every complete section.
+public:
+  cSectionAssembler(void);
+  virtual ~cSectionAssembler() {}
+  void Reset(void);
+  void Put(const uchar *Data);
+       ///< Puts the TS packet in Data into this assembler.
+  };
+
+cSectionAssembler::cSectionAssembler(void)
+{
+  Reset();
+}
+
+void cSectionAssembler::Reset(void)
+{
+  length = 0;
+  synced = false;
+  counter = -1;
+}
+
+void cSectionAssembler::Append(const uchar *Data, int Length)
+{
+  if (length + Length > int(sizeof(buffer))) {
+     Reset();
+     return;
+     }
+  memcpy(buffer + length, Data, Length);
+  length += Length;
+  while (length >= 3) {
+        if (buffer[0] == 0xFF) { // stuffing
+           length = 0;
+           synced = false;
+           break;
+           }
+        int l = 3 + (((buffer[1] & 0x0F) << 8) | buffer[2]);
+        if (length < l)
+           break;
+        Section(buffer, l);
+        length -= l;
+        memmove(buffer, buffer + l, length);
+        }
+}
+
+void cSectionAssembler::Put(const uchar *Data)
+{
+  if (TsError(Data)) {
+     Reset();
+     return;
+     }
+  if (!TsHasPayload(Data))
+     return;
+  int Counter = TsContinuityCounter(Data);
+  if (counter >= 0 && Counter != ((counter + 1) & TS_CONT_CNT_MASK)) {
+     if (Counter == counter)
+        return; // duplicate packet
+     length = 0;
+     synced = false;
+     }
+  counter = Counter;
+  const uchar *p = Data;
+  int l = TsGetPayload(&p);
+  if (TsPayloadStart(Data)) {
+     int Pointer = *p++;
+     l--;
+     if (Pointer > l) {
+        Reset();
+        return;
+        }
+     if (synced)
+        Append(p, Pointer); // completes the previous section
+     p += Pointer;
+     l -= Pointer;
+     length = 0;
+     synced = true;
+     }
+  if (synced)
+     Append(p, l);
+}
+
+// --- cFileSectionFilter ----------------------------------------------------
+
+class cFileSectionFilter : public cSectionAssembler {
+private:
+  int fd;
+protected:
+  virtual void Section(const uchar *Data, int Length) override;
+public:
+  int pid;
+  uchar tid;
+  uchar mask;
+  int handle;
+  cFileSectionFilter(int Pid, uchar Tid, uchar Mask, int Handle, int Fd);
+  virtual ~cFileSectionFilter() override;
+  };
+
+cFileSectionFilter::cFileSectionFilter(int Pid, uchar Tid, uchar Mask, int Handle, int Fd)
+{
+  pid = Pid;
+  tid = Tid;
+  mask = Mask;
+  handle = Handle;
+  fd = Fd;
+}
+
+cFileSectionFilter::~cFileSectionFilter()
+{
+  close(fd);
+}
+
+void cFileSectionFilter::Section(const uchar *Data, int Length)
+{
+  if ((Data[0] & mask) == (tid & mask)) {
+     if (send(fd, Data, Length, MSG_DONTWAIT | MSG_NOSIGNAL) < 0 && errno != EAGAIN)
+        LOG_ERROR;
+     }
+}
+
+// --- cPatScanner -----------------------------------------------------------
+
+class cPatScanner : public cSectionAssembler {
+private:
+  cVector<int> &sids;
+  int &tid;
+  bool done;
+protected:
+  virtual void Section(const uchar *Data, int Length) override;
+public:
+  cPatScanner(cVector<int> &Sids, int &Tid) : sids(Sids), tid(Tid) { done = false; }
+  bool Done(void) { return done; }
+  };
+
+void cPatScanner::Section(const uchar *Data, int Length)
+{
+  if (Data[0] == SI::TableIdPAT) {
+     SI::PAT pat(Data, false);
+     if (pat.CheckCRCAndParse()) {
+        tid = pat.getTransportStreamId();
+        SI::PAT::Association assoc;
+        for (SI::Loop::Iterator it; pat.associationLoop.getNext(assoc, it); ) {
+            if (!assoc.isNITPid())
+               sids.AppendUnique(assoc.getServiceId());
+            }
+        done = pat.getSectionNumber() == pat.getLastSectionNumber();
+        }
+     }
+}
+
+// --- cSdtScanner -----------------------------------------------------------
+
+class cSdtScanner : public cSectionAssembler {
+private:
+  int &nid;
+  int &tid;
+  bool done;
+protected:
+  virtual void Section(const uchar *Data, int Length) override;
+public:
+  cSdtScanner(int &Nid, int &Tid) : nid(Nid), tid(Tid) { done = false; }
+  bool Done(void) { return done; }
+  };
+
+void cSdtScanner::Section(const uchar *Data, int Length)
+{
+  if (Data[0] == SI::TableIdSDT) { // "actual transport stream" only
+     SI::SDT sdt(Data, false);
+     if (sdt.CheckCRCAndParse()) {
+        nid = sdt.getOriginalNetworkId();
+        tid = sdt.getTransportStreamId();
+        done = true;
+        }
+     }
+}
+
+// --- cTsFileReader ---------------------------------------------------------
+
+class cTsFileReader : public cThread {
+private:
+  cString fileName;
+  bool unlimited;
+  int deviceNumber;
+  cMutex mutex;
+  int dvr;
+  bool pids[MAXPID];
+  cVector<cFileSectionFilter *> filters;
+  int pcrPid;
+  int64_t firstPcr;
+  cTimeMs pcrTimer;
+  time_t lastOverflowReport;
+  int overflowCount;
+  int overflowBytes;
+  int PcrWait(const uchar *Data);
+       ///< Returns the number of ms to wait before delivering the TS packet in Data.
+  void Distribute(const uchar *Data, int Length);
+  void WriteDvr(const uchar *Data, int Length);
+protected:
+  virtual void Action(void) override;
+public:
+  cTsFileReader(const char *FileName, bool Unlimited, int DeviceNumber);
+  virtual ~cTsFileReader() override;
+  void SetDvr(int Fd);
+  void SetPid(int Pid, bool On);
+  int OpenFilter(int Pid, uchar Tid, uchar Mask);
+  void CloseFilter(int Handle);
+  };
+
+cTsFileReader::cTsFileReader(const char *FileName, bool Unlimited, int DeviceNumber)
+:cThread(NULL, true)
+{
+  SetDescription("device %d file reader", DeviceNumber);
+  fileName = FileName;
+  unlimited = Unlimited;
+  deviceNumber = DeviceNumber;
+  dvr = -1;
+  memset(pids, 0, sizeof(pids));
+  pcrPid = -1;
+  firstPcr = -1;
+  lastOverflowReport = 0;
+  overflowCount = overflowBytes = 0;
+}
+
+cTsFileReader::~cTsFileReader()
+{
+  Cancel(3);
+  for (int i = 0; i < filters.Size(); i++)
+      delete filters[i];
+}
+
+void cTsFileReader::SetDvr(int Fd)
+{
+  cMutexLock MutexLock(&mutex);
+  dvr = Fd;
+}
+
+void cTsFileReader::SetPid(int Pid, bool On)
+{
+  cMutexLock MutexLock(&mutex);
+  pids[Pid & (MAXPID - 1)] = On;
+}
+
+int cTsFileReader::OpenFilter(int Pid, uchar Tid, uchar Mask)
+{
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0) {
+     LOG_ERROR;
+     return -1;
+     }
+  cMutexLock MutexLock(&mutex);
+  filters.Append(new cFileSectionFilter(Pid, Tid, Mask, fds[0], fds[1]));
+  return fds[0];
+}
+
+void cTsFileReader::CloseFilter(int Handle)
+{
+  cMutexLock MutexLock(&mutex);
+  for (int i = 0; i < filters.Size(); i++) {
+      if (filters[i]->handle == Handle) {
+         delete filters[i];
+         filters.Remove(i);
+         break;
+         }
+      }
+  close(Handle);
+}
+
+int cTsFileReader::PcrWait(const uchar *Data)
+{
+  // Use the PCR of the first PID that has one to deliver the data in real time:
+  if (pcrPid >= 0 && TsPid(Data) != pcrPid)
+     return 0;
+  int64_t Pcr = TsGetPcr(Data);
+  if (Pcr >= 0) {
+     pcrPid = TsPid(Data);
+     int64_t Ms = firstPcr >= 0 ? (Pcr - firstPcr) / (PCRFACTOR * PTSTICKS / 1000) : -1;
+     int64_t Elapsed = pcrTimer.Elapsed();
+     if (Ms < 0 || Ms > Elapsed + MAXPCRJUMP) {
+        firstPcr = Pcr; // start or discontinuity
+        pcrTimer.Set();
+        }
+     else if (Ms > Elapsed)
+        return Ms - Elapsed;
+     }
+  return 0;
+}
+
+void cTsFileReader::Distribute(const uchar *Data, int Length)
+{
+  uchar Buffer[TSFILECHUNK];
+  int Wanted = 0;
+  cMutexLock MutexLock(&mutex);
+  for (int i = 0; i + TS_SIZE <= Length; i += TS_SIZE) {
+      const uchar *p = Data + i;
+      int Pid = TsPid(p);
+      for (int f = 0; f < filters.Size(); f++) {
+          if (filters[f]->pid == Pid)
+             filters[f]->Put(p);
+          }
+      if (pids[Pid] && dvr >= 0) {
+         memcpy(Buffer + Wanted, p, TS_SIZE);
+         Wanted += TS_SIZE;
+         }
+      }
+  if (Wanted)
+     WriteDvr(Buffer, Wanted);
+}
+
+void cTsFileReader::WriteDvr(const uchar *Data, int Length)
+{
+  while (Length > 0 && dvr >= 0 && Running()) {
+        int w = write(dvr, Data, Length);
+        if (w > 0) {
+           Data += w;
+           Length -= w;
+           }
+        else if (w < 0 && errno != EAGAIN) {
+           LOG_ERROR;
+           break;
+           }
+        else if (unlimited) {
+           // let the consumer determine the speed:
+           mutex.Unlock();
+           cCondWait::SleepMs(1);
+           mutex.Lock();
+           }
+        else {
+           overflowCount++;
+           overflowBytes += Length;
+           if (time(NULL) - lastOverflowReport > OVERFLOWREPORTDELTA) {
+              esyslog("ERROR: %d DVR buffer overflow%s on device %d (%d bytes dropped)", overflowCount, overflowCount > 1 ? "s" : "", deviceNumber, overflowBytes);
+              overflowCount = overflowBytes = 0;
+              lastOverflowReport = time(NULL);
+              }
+           break;
+           }
+        }
+}
+
+void cTsFileReader::Action(void)
+{
+  int f = open(fileName, O_RDONLY);
+  if (f < 0) {
+     LOG_ERROR_STR(*fileName);
+     return;
+     }
+  uchar Buffer[TSFILECHUNK];
+  int Length = 0;
+  while (Running()) {
+        if (unlimited) {
+           mutex.Lock();
+           bool Idle = dvr < 0;
+           mutex.Unlock();
+           if (Idle) {
+              cCondWait::SleepMs(100);
+              continue;
+              }
+           }
+        int r = safe_read(f, Buffer + Length, sizeof(Buffer) - Length);
+        if (r < 0) {
+           LOG_ERROR_STR(*fileName);
+           break;
+           }
+        if (r == 0) { // end of file, start all over again
+           if (lseek(f, 0, SEEK_SET) < 0) {
+              LOG_ERROR_STR(*fileName);
+              break;
+              }
+           Length = 0;
+           firstPcr = -1;
+           continue;
+           }
+        Length += r;
+        if (int Skipped = TS_SYNC(Buffer, Length)) {
+           Length -= Skipped;
+           memmove(Buffer, Buffer + Skipped, Length);
+           continue;
+           }
+        int Count = Length / TS_SIZE * TS_SIZE;
+        int Done = 0;
+        if (!unlimited) {
+           for (int i = 0; i < Count; i += TS_SIZE) {
+               if (int Wait = PcrWait(Buffer + i)) {
+                  Distribute(Buffer + Done, i - Done);
+                  Done = i;
+                  cCondWait::SleepMs(Wait);
+                  }
+               }
+           }
+        Distribute(Buffer + Done, Count - Done);
+        Length -= Count;
+        memmove(Buffer, Buffer + Count, Length);
+        }
+  close(f);
+}
+
+// --- cFileDevice -----------------------------------------------------------
+
+cFileDevice::cFileDevice(const char *FileName, bool Unlimited)
+{
+  fileName = FileName;
+  nid = tid = -1;
+  tuned = false;
+  fd_dvr[0] = fd_dvr[1] = -1;
+  tsBuffer = NULL;
+  ScanSids();
+  isyslog("device %d reads TS file '%s'%s (%d service%s, NID %d, TID %d)", DeviceNumber() + 1, *fileName, Unlimited ? " at unlimited rate" : "", sids.Size(), sids.Size() == 1 ? "" : "s", nid, tid);
+  reader = new cTsFileReader(fileName, Unlimited, DeviceNumber() + 1);
+  reader->Start();
+  StartSectionHandler();
+}
+
+cFileDevice::~cFileDevice()
+{
+  StopSectionHandler();
+  DetachAllReceivers();
+  Cancel(3); // the receiver thread must no longer access the reader
+  CloseDvr();
+  delete reader;
+}
+
+void cFileDevice::ScanSids(void)
+{
+  int f = open(fileName, O_RDONLY);
+  if (f >= 0) {
+     cPatScanner PatScanner(sids, tid);
+     cSdtScanner SdtScanner(nid, tid);
+     uchar Buffer[TSFILECHUNK];
+     int Length = 0;
+     int Total = 0;
+     while (Total < TSFILESCANSIZE && !(PatScanner.Done() && SdtScanner.Done())) {
+           int r = safe_read(f, Buffer + Length, sizeof(Buffer) - Length);
+           if (r <= 0)
+              break;
+           Total += r;
+           Length += r;
+           if (int Skipped = TS_SYNC(Buffer, Length)) {
+              Length -= Skipped;
+              memmove(Buffer, Buffer + Skipped, Length);
+              continue;
+              }
+           int i = 0;
+           for ( ; i + TS_SIZE <= Length; i += TS_SIZE) {
+               if (TsPid(Buffer + i) == PATPID)
+                  PatScanner.Put(Buffer + i);
+               else if (TsPid(Buffer + i) == SDTPID)
+                  SdtScanner.Put(Buffer + i);
+               }
+           Length -= i;
+           memmove(Buffer, Buffer + i, Length);
+           }
+     close(f);
+     if (!sids.Size())
+        esyslog("ERROR: no PAT found in TS file '%s'", *fileName);
+     }
+  else
+     LOG_ERROR_STR(*fileName);
+}
+
+cString cFileDevice::DeviceType(void) const
+{
+  return "FILE";
+}
+
+cString cFileDevice::DeviceName(void) const
+{
+  return fileName;
+}
+
+bool cFileDevice::ProvidesSource(int Source) const
+{
+  return true; // the file doesn't tell which source the stream has been received from
+}
+
+bool cFileDevice::ProvidesTransponder(const cChannel *Channel) const
+{
+  if (tid >= 0 && Channel->Tid() != tid)
+     return false;
+  if (nid >= 0 && Channel->Nid() != nid)
+     return false;
+  for (int i = 0; i < sids.Size(); i++) {
+      if (sids[i] == Channel->Sid())
+         return true;
+      }
+  return false;
+}
+
+bool cFileDevice::ProvidesChannel(const cChannel *Channel, int Priority, bool *NeedsDetachReceivers) const
+{
+  bool result = false;
+  bool hasPriority = Priority == IDLEPRIORITY || Priority > this->Priority();
+  bool needsDetachReceivers = false;
+
+  if (ProvidesTransponder(Channel)) {
+     result = hasPriority;
+     // all services in the file are on the same "transponder":
+     if (Priority > IDLEPRIORITY && Receiving() && IsTunedToTransponder(Channel))
+        result = true;
+     }
+  if (NeedsDetachReceivers)
+     *NeedsDetachReceivers = needsDetachReceivers;
+  return result;
+}
+
+int cFileDevice::NumProvidedSystems(void) const
+{
+  return 1;
+}
+
+bool cFileDevice::IsTunedToTransponder(const cChannel *Channel) const
+{
+  return tuned && ProvidesTransponder(Channel);
+}
+
+bool cFileDevice::SetChannelDevice(const cChannel *Channel, bool LiveView)
+{
+  tuned = ProvidesTransponder(Channel);
+  return tuned;
+}
+
+bool cFileDevice::SetPid(cPidHandle *Handle, int Type, bool On)
+{
+  reader->SetPid(Handle->pid, On || Handle->used > 0);
+  return true;
+}
+
+int cFileDevice::OpenFilter(u_short Pid, u_char Tid, u_char Mask)
+{
+  return reader->OpenFilter(Pid, Tid, Mask);
+}
+
+void cFileDevice::CloseFilter(int Handle)
+{
+  reader->CloseFilter(Handle);
+}
+
+bool cFileDevice::OpenDvr(void)
+{
+  CloseDvr();
+  int fds[2];
+  if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+     LOG_ERROR;
+     return false;
+     }
+  fd_dvr[0] = fds[0];
+  fd_dvr[1] = fds[1];
+  fcntl(fd_dvr[1], F_SETPIPE_SZ, TSFILEPIPESIZE);
+  tsBuffer = new cTSBuffer(fd_dvr[0], TSFILEBUFSIZE, DeviceNumber() + 1);
+  reader->SetDvr(fd_dvr[1]);
+  return true;
+}
+
+void cFileDevice::CloseDvr(void)
+{
+  if (fd_dvr[0] >= 0) {
+     reader->SetDvr(-1);
+     close(fd_dvr[1]);
+     delete tsBuffer;
+     tsBuffer = NULL;
+     close(fd_dvr[0]);
+     fd_dvr[0] = fd_dvr[1] = -1;
+     }
+}
+
+bool cFileDevice::GetTSPacket(uchar *&Data)
+{
+  if (tsBuffer) {
+     Data = tsBuffer->Get();
+     return true;
+     }
+  return false;
+}
+
+bool cFileDevice::GetTSPackets(uchar *&Data, int &Count)
+{
+  if (tsBuffer) {
+     Data = tsBuffer->GetPackets(Count, MAXTSPACKETSPERRUN);
+     return true;
+     }
+  return false;
+}
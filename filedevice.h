@@ -0,0 +1,64 @@
+/*
+ * filedevice.h: A device that reads a Transport Stream from a file
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#ifndef __FILEDEVICE_H
+#define __FILEDEVICE_H
+
+#include "device.h"
+
+class cTsFileReader;
+
+/// cFileDevice is a device that "receives" the Transport Stream contained in
+/// a file instead of getting it from DVB hardware. It provides all channels
+/// whose service ids are listed in the PAT of that file and whose transport
+/// stream id (and original network id, if the file contains an SDT) are the
+/// same as those of the stream in that file, and serves section
+/// filters from the TS data itself. This allows running receivers, recorders
+/// and the section handler without any hardware, for instance to measure the
+/// throughput of these on a build machine.
+/// The file is read in real time (paced by the PCR values of the stream) or,
+/// if Unlimited is true, as fast as the consumer can take the data. In the
+/// latter case data is only read while a receiver is attached. When the end
+/// of the file is reached, reading continues at its beginning.
+
+class cFileDevice : public cDevice {
+private:
+  cString fileName;
+  cVector<int> sids;
+  int nid; // the original network id of the stream, -1 if unknown
+  int tid; // the transport stream id of the stream, -1 if unknown
+  bool tuned;
+  cTsFileReader *reader;
+  int fd_dvr[2]; // the pipe that emulates the DVR device
+  cTSBuffer *tsBuffer;
+  void ScanSids(void);
+       ///< Scans the beginning of the file for the PAT and SDT to get the service ids,
+       ///< the transport stream id and the original network id of the stream.
+public:
+  cFileDevice(const char *FileName, bool Unlimited = false);
+  virtual ~cFileDevice() override;
+  virtual cString DeviceType(void) const override;
+  virtual cString DeviceName(void) const override;
+  virtual bool ProvidesSource(int Source) const override;
+  virtual bool ProvidesTransponder(const cChannel *Channel) const override;
+  virtual bool ProvidesChannel(const cChannel *Channel, int Priority = IDLEPRIORITY, bool *NeedsDetachReceivers = NULL) const override;
+  virtual int NumProvidedSystems(void) const override;
+  virtual bool IsTunedToTransponder(const cChannel *Channel) const override;
+protected:
+  virtual bool SetChannelDevice(const cChannel *Channel, bool LiveView) override;
+  virtual bool SetPid(cPidHandle *Handle, int Type, bool On) override;
+  virtual int OpenFilter(u_short Pid, u_char Tid, u_char Mask) override;
+  virtual void CloseFilter(int Handle) override;
+  virtual bool OpenDvr(void) override;
+  virtual void CloseDvr(void) override;
+  virtual bool GetTSPacket(uchar *&Data) override;
+  virtual bool GetTSPackets(uchar *&Data, int &Count) override;
+  };
+
+#endif //__FILEDEVICE_H
@@ -0,0 +1 @@
+../../libsi/descriptor.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../libsi/headers.h
\ No newline at end of file
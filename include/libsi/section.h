@@ -0,0 +1 @@
+../../libsi/section.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../libsi/si.h
\ No newline at end of file
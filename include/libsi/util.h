@@ -0,0 +1 @@
+../../libsi/util.h
\ No newline at end of file
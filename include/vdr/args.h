@@ -0,0 +1 @@
+../../args.h
\ No newline at end of file
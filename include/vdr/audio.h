@@ -0,0 +1 @@
+../../audio.h
\ No newline at end of file
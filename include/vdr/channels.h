@@ -0,0 +1 @@
+../../channels.h
\ No newline at end of file
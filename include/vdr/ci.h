@@ -0,0 +1 @@
+../../ci.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../cutter.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../device.h
\ No newline at end of file
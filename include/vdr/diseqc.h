@@ -0,0 +1 @@
+../../diseqc.h
\ No newline at end of file
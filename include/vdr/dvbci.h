@@ -0,0 +1 @@
+../../dvbci.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../dvbdevice.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../dvbplayer.h
\ No newline at end of file
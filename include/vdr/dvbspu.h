@@ -0,0 +1 @@
+../../dvbspu.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../dvbsubtitle.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../eit.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../eitscan.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../epg.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../filedevice.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../font.h
\ No newline at end of file
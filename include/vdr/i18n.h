@@ -0,0 +1 @@
+../../i18n.h
\ No newline at end of file
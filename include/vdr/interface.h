@@ -0,0 +1 @@
+../../interface.h
\ No newline at end of file
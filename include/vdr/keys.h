@@ -0,0 +1 @@
+../../keys.h
\ No newline at end of file
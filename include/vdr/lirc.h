@@ -0,0 +1 @@
+../../lirc.h
\ No newline at end of file
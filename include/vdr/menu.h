@@ -0,0 +1 @@
+../../menu.h
\ No newline at end of file
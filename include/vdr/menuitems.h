@@ -0,0 +1 @@
+../../menuitems.h
\ No newline at end of file
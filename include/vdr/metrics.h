@@ -0,0 +1 @@
+../../metrics.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../mtd.h
\ No newline at end of file
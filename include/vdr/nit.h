@@ -0,0 +1 @@
+../../nit.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../osd.h
\ No newline at end of file
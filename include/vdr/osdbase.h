@@ -0,0 +1 @@
+../../osdbase.h
\ No newline at end of file
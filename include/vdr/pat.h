@@ -0,0 +1 @@
+../../pat.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../player.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../plugin.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../positioner.h
\ No newline at end of file
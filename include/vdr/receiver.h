@@ -0,0 +1 @@
+../../receiver.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../recorder.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../recording.h
\ No newline at end of file
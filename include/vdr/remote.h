@@ -0,0 +1 @@
+../../remote.h
\ No newline at end of file
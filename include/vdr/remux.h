@@ -0,0 +1 @@
+../../remux.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../ringbuffer.h
\ No newline at end of file
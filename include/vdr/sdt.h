@@ -0,0 +1 @@
+../../sdt.h
\ No newline at end of file
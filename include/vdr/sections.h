@@ -0,0 +1 @@
+../../sections.h
\ No newline at end of file
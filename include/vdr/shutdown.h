@@ -0,0 +1 @@
+../../shutdown.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../skinclassic.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../skinlcars.h
\ No newline at end of file
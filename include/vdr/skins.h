@@ -0,0 +1 @@
+../../skins.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../skinsttng.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../sourceparams.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../sources.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../spu.h
\ No newline at end of file
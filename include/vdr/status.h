@@ -0,0 +1 @@
+../../status.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../svdrp.h
\ No newline at end of file
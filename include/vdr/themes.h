@@ -0,0 +1 @@
+../../themes.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../thread.h
\ No newline at end of file
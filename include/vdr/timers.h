@@ -0,0 +1 @@
+../../timers.h
\ No newline at end of file
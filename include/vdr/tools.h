@@ -0,0 +1 @@
+../../tools.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../transfer.h
\ No newline at end of file
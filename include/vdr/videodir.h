@@ -0,0 +1 @@
+../../videodir.h
\ No newline at end of file
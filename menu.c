@@ -3833,6 +3833,8 @@ void cMenuSetupEPG::Setup(void)
   Add(new cMenuEditBoolItem(tr("Setup.EPG$EPG pause after scan"),      &data.EPGPauseAfterScan));
   Add(new cMenuEditIntItem( tr("Setup.EPG$EPG bugfix level"),          &data.EPGBugfixLevel, 0, MAXEPGBUGFIXLEVEL));
   Add(new cMenuEditIntItem( tr("Setup.EPG$EPG linger time (min)"),     &data.EPGLinger, 0));
+  Add(new cMenuEditBoolItem(tr("Setup.EPG$Save EPG data in binary format"), &data.EPGBinaryData));
+  Add(new cMenuEditBoolItem(tr("Setup.EPG$Save EPG data incrementally"), &data.EPGIncrementalSave));
   Add(new cMenuEditBoolItem(tr("Setup.EPG$Set system time"),           &data.SetSystemTime));
   if (data.SetSystemTime)
      Add(new cMenuEditTranItem(Indent(2, tr("Setup.EPG$Use time from transponder")), &data.TimeTransponder, &data.TimeSource));
@@ -4364,6 +4366,7 @@ cMenuSetupRecord::cMenuSetupRecord(void)
   Add(new cMenuEditIntItem( tr("Setup.Recording$Instant rec. time (min)"),   &data.InstantRecordTime, 0, MAXINSTANTRECTIME, tr("Setup.Recording$present event")));
   Add(new cMenuEditIntItem( tr("Setup.Recording$Max. video file size (MB)"), &data.MaxVideoFileSize, MINVIDEOFILESIZE, MAXVIDEOFILESIZETS));
   Add(new cMenuEditBoolItem(tr("Setup.Recording$Split edited files"),        &data.SplitEditedFiles));
+  Add(new cMenuEditIntItem( tr("Setup.Recording$Write buffer size (MB)"),    &data.WriteBufferSize, 0, MAXWRITEBUFFERSIZE, tr("off")));
   Add(new cMenuEditStraItem(tr("Setup.Recording$Delete timeshift recording"),&data.DelTimeshiftRec, 3, delTimeshiftRecTexts));
 }
 
@@ -4412,6 +4415,7 @@ class cMenuSetupMisc : public cMenuSetupBase {
 private:
   const char *svdrpPeeringModeTexts[3];
   const char *showChannelNamesWithSourceTexts[3];
+  const char *bufferHugePagesTexts[3];
   cStringList svdrpServerNames;
   void Set(void);
 public:
@@ -4428,6 +4432,9 @@ cMenuSetupMisc::cMenuSetupMisc(void)
   showChannelNamesWithSourceTexts[0] = tr("off");
   showChannelNamesWithSourceTexts[1] = tr("type");
   showChannelNamesWithSourceTexts[2] = tr("full");
+  bufferHugePagesTexts[0] = tr("off");
+  bufferHugePagesTexts[1] = tr("transparent");
+  bufferHugePagesTexts[2] = tr("hugetlbfs");
   SetSection(tr("Miscellaneous"));
   Set();
 }
@@ -4460,6 +4467,8 @@ void cMenuSetupMisc::Set(void)
   Add(new cMenuEditBoolItem(tr("Setup.Miscellaneous$Channels wrap"),              &data.ChannelsWrap));
   Add(new cMenuEditStraItem(tr("Setup.Miscellaneous$Show channel names with source"), &data.ShowChannelNamesWithSource, 3, showChannelNamesWithSourceTexts));
   Add(new cMenuEditBoolItem(tr("Setup.Miscellaneous$Emergency exit"),             &data.EmergencyExit));
+  Add(new cMenuEditStraItem(tr("Setup.Miscellaneous$Huge pages for buffers"),     &data.BufferHugePages, 3, bufferHugePagesTexts));
+  Add(new cMenuEditBoolItem(tr("Setup.Miscellaneous$NUMA local buffers"),         &data.BufferNumaLocal));
   SetCurrent(Get(current));
   Display();
 }
@@ -0,0 +1,57 @@
+/*
+ * metrics.c: Runtime metrics
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#include "metrics.h"
+#include "config.h"
+#include "device.h"
+#include "epg.h"
+#include "ringbuffer.h"
+#include "videodir.h"
+
+#define METRICSINTERVAL 10 // seconds between writing the metrics file
+
+// --- cMetrics --------------------------------------------------------------
+
+cString cMetrics::fileName;
+time_t cMetrics::lastWrite = 0;
+
+void cMetrics::SetFileName(const char *FileName)
+{
+  fileName = FileName;
+}
+
+void cMetrics::GetMetrics(cStringList &Lines)
+{
+  Lines.Append(strdup(cString::sprintf("vdr version=%s time=%ld", VDRVERSION, time(NULL))));
+  int FreeMB, UsedMB;
+  int Percent = cVideoDirectory::VideoDiskSpace(&FreeMB, &UsedMB);
+  Lines.Append(strdup(cString::sprintf("disk total=%d free=%d used=%d%%", FreeMB + UsedMB, FreeMB, Percent)));
+  Lines.Append(strdup(cString::sprintf("framepool %s", *cFramePool::Metrics())));
+  Lines.Append(strdup(cString::sprintf("readcache %s", *cUnbufferedFile::Metrics())));
+  Lines.Append(strdup(cString::sprintf("epg %s", *cEvent::Metrics())));
+  for (int i = 0; i < cDevice::NumDevices(); i++) {
+      if (const cDevice *Device = cDevice::GetDevice(i))
+         Device->GetMetrics(Lines);
+      }
+}
+
+void cMetrics::Process(void)
+{
+  if (*fileName && time(NULL) - lastWrite >= METRICSINTERVAL) {
+     cStringList Lines;
+     GetMetrics(Lines);
+     cSafeFile f(fileName);
+     if (f.Open()) {
+        for (int i = 0; i < Lines.Size(); i++)
+            fprintf(f, "%s\n", Lines[i]);
+        f.Close();
+        }
+     lastWrite = time(NULL);
+     }
+}
@@ -0,0 +1,45 @@
+/*
+ * metrics.h: Runtime metrics
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#ifndef __METRICS_H
+#define __METRICS_H
+
+#include "tools.h"
+
+/// cMetrics collects runtime metrics of VDR, the video disk, all devices and
+/// their receivers (including any recordings) in a simple, machine readable
+/// format. Each line starts with the kind of object it describes ("vdr", "disk",
+/// "framepool", "readcache", "epg", "device" or "receiver"), optionally followed
+/// by the number of that object, and a list of "key=value" pairs (see
+/// cFramePool::Metrics(), cUnbufferedFile::Metrics(), cEvent::Metrics(),
+/// cDevice::GetMetrics() and cReceiver::Metrics()). Values that may contain
+/// blanks or '=' are enclosed in double quotes, with any '"' and '\\' inside
+/// them escaped by a backslash. Keys will never be
+/// removed or change their meaning, but new keys may be added in future
+/// versions.
+/// The metrics can be retrieved via the SVDRP command "STAT METRICS", and are
+/// written to a file in regular intervals if a file name has been given with
+/// the command line option --metrics.
+
+class cMetrics {
+private:
+  static cString fileName;
+  static time_t lastWrite;
+public:
+  static void SetFileName(const char *FileName);
+       ///< Sets the name of the file the metrics shall be written to.
+  static void GetMetrics(cStringList &Lines);
+       ///< Appends lines with the current metrics to Lines.
+  static void Process(void);
+       ///< Writes the current metrics into the file set with SetFileName(), if
+       ///< the last time it has been written is long enough ago.
+       ///< This function is called from the main program loop.
+  };
+
+#endif //__METRICS_H
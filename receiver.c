@@ -16,6 +16,7 @@ cReceiver::cReceiver(const cChannel *Channel, int Priority)
   device = NULL;
   SetPriority(Priority);
   numPids = 0;
+  packets = 0;
   lastScrambledPacket = 0;
   startScrambleDetection = 0;
   scramblingTimeout = 0;
@@ -45,8 +46,11 @@ bool cReceiver::AddPid(int Pid)
      if (numPids < MAXRECEIVEPIDS) {
         if (!WantsPid(Pid)) {
            pids[numPids++] = Pid;
-           if (device)
+           if (device) {
               device->AddPid(Pid);
+              cMutexLock MutexLock(&device->mutexReceiver);
+              device->UpdateReceiverMask();
+              }
            }
         }
      else {
@@ -95,8 +99,11 @@ void cReceiver::DelPid(int Pid)
             for ( ; i < numPids; i++) // we also copy the terminating 0!
                 pids[i] = pids[i + 1];
             numPids--;
-            if (device)
+            if (device) {
                device->DelPid(Pid);
+               cMutexLock MutexLock(&device->mutexReceiver);
+               device->UpdateReceiverMask();
+               }
             return;
             }
          }
@@ -122,6 +129,12 @@ bool cReceiver::WantsPid(int Pid)
   return false;
 }
 
+void cReceiver::ReceivePackets(const uchar *Data, int Count)
+{
+  for (int i = 0; i < Count; i++, Data += TS_SIZE)
+      Receive(Data, TS_SIZE);
+}
+
 void cReceiver::Detach(void)
 {
   if (device)
@@ -22,6 +22,7 @@ private:
   int priority;
   int pids[MAXRECEIVEPIDS];
   int numPids;
+  int64_t packets;
   time_t lastScrambledPacket;
   time_t startScrambleDetection;
   int scramblingTimeout;
@@ -43,6 +44,15 @@ protected:
                ///< as soon as possible, without any unnecessary delay. Each TS packet
                ///< will be delivered only ONCE, so the cReceiver must make sure that
                ///< it will be able to buffer the data if necessary.
+  virtual void ReceivePackets(const uchar *Data, int Count);
+               ///< This function is called from the cDevice we are attached to, and
+               ///< delivers Count consecutive TS packets (each of them TS_SIZE bytes
+               ///< long) that all have the same PID from the set of PIDs the cReceiver
+               ///< has requested. The same rules as for Receive() apply.
+               ///< The default implementation calls Receive() for each single packet.
+               ///< A derived class that can handle several packets at once more
+               ///< efficiently (for instance by storing them in a buffer with a single
+               ///< call) may reimplement this function.
 public:
   cReceiver(const cChannel *Channel = NULL, int Priority = MINPRIORITY);
                ///< Creates a new receiver for the given Channel with the given Priority.
@@ -55,6 +65,15 @@ public:
                ///< or live viewing (without blocking the cDevice it is attached to).
   virtual ~cReceiver();
   int Priority(void) { return priority; }
+  int64_t Packets(void) { return packets; }
+               ///< Returns the number of TS packets that have been delivered to this receiver.
+  virtual cString Metrics(void) { return NULL; }
+               ///< Returns any additional runtime metrics of this receiver, in the form
+               ///< "key=value key=value...". A derived class can reimplement this function
+               ///< to provide information about what it does with the data it receives.
+               ///< This function is called from a different thread than Receive(), so
+               ///< it must not access any data that might become invalid while it runs.
+               ///< See cDevice::GetMetrics().
   void SetPriority(int Priority);
   bool AddPid(int Pid);
                ///< Adds the given Pid to the list of PIDs of this receiver.
@@ -20,6 +20,29 @@
 #define MINFREEDISKSPACE    (512) // MB
 #define DISKCHECKINTERVAL   100 // seconds
 
+#define SLOWWRITETIME       100 // ms, writes that take longer than this are counted as "slow"
+
+// --- cPendingIndexEntry ----------------------------------------------------
+
+class cPendingIndexEntry : public cListObject {
+public:
+  bool independent;
+  uint16_t number;
+  off_t offset;
+  bool errors;
+  bool missing;
+  off_t end; // the offset up to which the file must have been written
+  cPendingIndexEntry(bool Independent, uint16_t Number, off_t Offset, bool Errors, bool Missing, off_t End)
+  {
+    independent = Independent;
+    number = Number;
+    offset = Offset;
+    errors = Errors;
+    missing = Missing;
+    end = End;
+  }
+  };
+
 // --- cRecorder -------------------------------------------------------------
 
 cRecorder::cRecorder(const char *FileName, const cChannel *Channel, int Priority)
@@ -35,6 +58,11 @@ cRecorder::cRecorder(const char *FileName, const cChannel *Channel, int Priority
   lastErrors = oldErrors + tmpErrors;
   working = false;
   firstIframeSeen = false;
+  overflowBytes = 0;
+  numWrites = 0;
+  slowWrites = 0;
+  maxWriteTime = 0;
+  bytesWritten = 0;
 
   // Make sure the disk is up and running:
 
@@ -55,6 +83,11 @@ cRecorder::cRecorder(const char *FileName, const cChannel *Channel, int Priority
      Type = 0x06;
      }
   frameDetector = new cFrameDetector(Pid, Type);
+  for (int i = 0; Channel->Apid(i); i++)
+      frameDetector->AddStream(Channel->Apid(i), Channel->Atype(i));
+  for (int i = 0; Channel->Dpid(i); i++)
+      frameDetector->AddStream(Channel->Dpid(i), Channel->Dtype(i));
+  lastDropouts = 0;
   index = NULL;
   fileSize = 0;
   lastDiskSpaceCheck = time(NULL);
@@ -68,6 +101,7 @@ cRecorder::cRecorder(const char *FileName, const cChannel *Channel, int Priority
   recordFile = fileName->Open();
   if (!recordFile)
      return;
+  recordFile->SetAsyncWrite(MEGABYTE(Setup.WriteBufferSize));
   // Create the index file:
   index = new cIndexFile(FileName, true);
   if (!index)
@@ -86,6 +120,13 @@ cRecorder::~cRecorder()
   free(recordingName);
 }
 
+cString cRecorder::Metrics(void)
+{
+  cMutexLock MutexLock(&metricsMutex);
+  return cString::sprintf("written=%" PRId64 " buffer=%d%% dropped=%d writes=%d slowwrites=%d maxwritetime=%d errors=%d dropouts=%d recording=\"%s\"",
+           bytesWritten, ringBuffer->MaxFill(), overflowBytes, numWrites, slowWrites, maxWriteTime, lastErrors, lastDropouts, *strescape(recordingName, "\"\\"));
+}
+
 void cRecorder::Stop(void)
 {
   Cancel(3);
@@ -103,10 +144,22 @@ void cRecorder::HandleErrors(bool Force)
         esyslog("%s: %d new error%s (total %d)", recordingName, d, d > 1 ? "s" : "", AllErrors);
         recordingInfo->SetErrors(AllErrors, tmpErrors);
         recordingInfo->Write();
-        LOCK_RECORDINGS_WRITE;
-        Recordings->UpdateByName(recordingName);
+        {
+          LOCK_RECORDINGS_WRITE;
+          Recordings->UpdateByName(recordingName);
+        }
+        cMutexLock MutexLock(&metricsMutex);
         lastErrors = AllErrors;
         }
+     int Dropouts = 0;
+     for (int i = 0; i < frameDetector->NumStreams(); i++)
+         Dropouts += frameDetector->Stream(i)->Dropouts();
+     if (Dropouts != lastDropouts) {
+        int d = Dropouts - lastDropouts;
+        esyslog("%s: %d new audio dropout%s (total %d)", recordingName, d, d > 1 ? "s" : "", Dropouts);
+        cMutexLock MutexLock(&metricsMutex);
+        lastDropouts = Dropouts;
+        }
      lastErrorLog = time(NULL);
      }
 }
@@ -130,6 +183,8 @@ bool cRecorder::NextFile(void)
      if (fileSize > MEGABYTE(off_t(Setup.MaxVideoFileSize)) || RunningLowOnDiskSpace()) {
         recordFile = fileName->NextFile();
         fileSize = 0;
+        if (recordFile)
+           recordFile->SetAsyncWrite(MEGABYTE(Setup.WriteBufferSize));
         }
      }
   return recordFile != NULL;
@@ -143,34 +198,105 @@ void cRecorder::Activate(bool On)
      Cancel(3);
 }
 
+static inline bool IsAdaptationFieldFiller(const uchar *Data)
+{
+  static const uchar aff[TS_SIZE - 4] = { 0xB7, 0x00,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF};
+  return (Data[3] & 0b00110000) == 0b00100000 && !memcmp(Data + 4, aff, sizeof(aff));
+}
+
+void cRecorder::Put(const uchar *Data, int Length)
+{
+  if (Length > 0) {
+     int p = ringBuffer->Put(Data, Length);
+     if (p != Length && working) {
+        ringBuffer->ReportOverflow(Length - p);
+        cMutexLock MutexLock(&metricsMutex);
+        overflowBytes += Length - p;
+        }
+     }
+}
+
+bool cRecorder::WriteData(const uchar *Data, int Length)
+{
+  cTimeMs Timer;
+  if (recordFile->Write(Data, Length) < 0)
+     return false;
+  int Elapsed = int(Timer.Elapsed());
+  fileSize += Length;
+  cMutexLock MutexLock(&metricsMutex);
+  numWrites++;
+  if (Elapsed > SLOWWRITETIME)
+     slowWrites++;
+  maxWriteTime = max(maxWriteTime, Elapsed);
+  bytesWritten += Length;
+  return true;
+}
+
+void cRecorder::WriteIndex(bool Independent, uint16_t Number, off_t Offset, bool Errors, bool Missing)
+{
+  // With asynchronous writes the index entry of a frame must not be written before
+  // the frame's data is actually in the file, because otherwise a player (like in
+  // time shift mode) might try to read data that isn't there, yet. The data of the
+  // frame ends at the current fileSize (unless we have already switched to the next
+  // file, which has flushed the previous one):
+  if (!pendingIndex.First() && (!recordFile || Number != fileName->Number() || recordFile->Written() >= fileSize))
+     index->Write(Independent, Number, Offset, Errors, Missing);
+  else
+     pendingIndex.Add(new cPendingIndexEntry(Independent, Number, Offset, Errors, Missing, fileSize));
+}
+
+void cRecorder::FlushIndex(bool Force)
+{
+  if (Force && recordFile)
+     recordFile->Flush();
+  while (cPendingIndexEntry *e = pendingIndex.First()) {
+        if (!Force && recordFile && e->number == fileName->Number() && recordFile->Written() < e->end)
+           break;
+        index->Write(e->independent, e->number, e->offset, e->errors, e->missing);
+        pendingIndex.Del(e);
+        }
+}
+
 void cRecorder::Receive(const uchar *Data, int Length)
 {
   if (working) {
-     static const uchar aff[TS_SIZE - 4] = { 0xB7, 0x00,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-       0xFF, 0xFF}; // Length is always TS_SIZE!
-     if ((Data[3] & 0b00110000) == 0b00100000 && !memcmp(Data + 4, aff, sizeof(aff)))
+     if (IsAdaptationFieldFiller(Data)) // Length is always TS_SIZE!
         return; // Adaptation Field Filler found, skipping
-     int p = ringBuffer->Put(Data, Length);
-     if (p != Length && working)
-        ringBuffer->ReportOverflow(Length - p);
+     Put(Data, Length);
+     }
+}
+
+void cRecorder::ReceivePackets(const uchar *Data, int Count)
+{
+  if (working) {
+     // Store runs of packets with a single Put(), skipping Adaptation Field Fillers:
+     const uchar *p = Data;
+     for (int i = 0; i < Count; i++, Data += TS_SIZE) {
+         if (IsAdaptationFieldFiller(Data)) {
+            Put(p, Data - p);
+            p = Data + TS_SIZE;
+            }
+         }
+     Put(p, Data - p);
      }
 }
 
@@ -284,7 +410,7 @@ void cRecorder::Action(void)
                     if (frameDetector->NewFrame(PreviousErrors, MissingFrames)) {
                        if (index) {
                           if (pendNumber > 0)
-                             index->Write(pendIndependentFrame, pendNumber, pendFileSize, PreviousErrors, pendMissing);
+                             WriteIndex(pendIndependentFrame, pendNumber, pendFileSize, PreviousErrors, pendMissing);
                           pendIndependentFrame = frameDetector->IndependentFrame();
                           pendNumber = fileName->Number();
                           pendFileSize = fileSize;
@@ -295,34 +421,32 @@ void cRecorder::Action(void)
                     if (frameDetector->IndependentFrame()) {
                        NumIframesSeen++;
                        tmpErrors = 0;
-                       recordFile->Write(patPmtGenerator.GetPat(), TS_SIZE);
-                       fileSize += TS_SIZE;
+                       WriteData(patPmtGenerator.GetPat(), TS_SIZE);
                        int Index = 0;
-                       while (uchar *pmt = patPmtGenerator.GetPmt(Index)) {
-                             recordFile->Write(pmt, TS_SIZE);
-                             fileSize += TS_SIZE;
-                             }
+                       while (uchar *pmt = patPmtGenerator.GetPmt(Index))
+                             WriteData(pmt, TS_SIZE);
                        t.Reset();
                        }
-                    if (recordFile->Write(b, Count) < 0) {
+                    if (!WriteData(b, Count)) {
                        LOG_ERROR_STR(fileName->Name());
                        break;
                        }
                     if (NumIframesSeen >= 2) // avoids extra log entry when resuming a recording
                        HandleErrors();
-                    fileSize += Count;
                     }
                  }
               ringBuffer->Del(Count);
               }
            }
+        if (pendingIndex.First())
+           FlushIndex();
         if (t.TimedOut()) {
            esyslog("ERROR: video data stream broken");
            tmpErrors += int(round(frameDetector->FramesPerSecond() * t.Elapsed() / 1000));
            if (pendNumber > 0) {
               bool PreviousErrors = false;
               errors = frameDetector->Errors(&PreviousErrors);
-              index->Write(pendIndependentFrame, pendNumber, pendFileSize, PreviousErrors, pendMissing);
+              WriteIndex(pendIndependentFrame, pendNumber, pendFileSize, PreviousErrors, pendMissing);
               pendNumber = 0;
               }
            HandleErrors(true);
@@ -340,7 +464,20 @@ void cRecorder::Action(void)
   if (pendNumber > 0) {
      bool PreviousErrors = false;
      errors = frameDetector->Errors(&PreviousErrors);
-     index->Write(pendIndependentFrame, pendNumber, pendFileSize, PreviousErrors, pendMissing);
+     WriteIndex(pendIndependentFrame, pendNumber, pendFileSize, PreviousErrors, pendMissing);
      }
+  FlushIndex(true);
   HandleErrors(true);
+  dsyslog("%s: %d writes (%d slower than %dms, max. %dms), %d bytes dropped", recordingName, numWrites, slowWrites, SLOWWRITETIME, maxWriteTime, overflowBytes);
+  cStringList StreamStatistics;
+  for (int i = 0; i < frameDetector->NumStreams(); i++) {
+      dsyslog("%s: %s", recordingName, *frameDetector->Stream(i)->ToString());
+      StreamStatistics.Append(strdup(frameDetector->Stream(i)->InfoString()));
+      }
+  if (StreamStatistics.Size()) {
+     recordingInfo->SetStreamStatistics(StreamStatistics);
+     recordingInfo->Write();
+     LOCK_RECORDINGS_WRITE;
+     Recordings->UpdateByName(recordingName);
+     }
 }
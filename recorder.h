@@ -16,6 +16,8 @@
 #include "ringbuffer.h"
 #include "thread.h"
 
+class cPendingIndexEntry;
+
 class cRecorder : public cReceiver, cThread {
 private:
   cRingBufferLinear *ringBuffer;
@@ -25,6 +27,7 @@ private:
   cRecordingInfo *recordingInfo;
   cIndexFile *index;
   cUnbufferedFile *recordFile;
+  cList<cPendingIndexEntry> pendingIndex; // index entries of frames that have not yet been written to disk
   char *recordingName;
   bool working;
   bool firstIframeSeen;
@@ -35,10 +38,25 @@ private:
   int tmpErrors;
   int errors;
   int lastErrors;
+  int lastDropouts;
+  int overflowBytes;
+  int numWrites;
+  int slowWrites;
+  int maxWriteTime;
+  int64_t bytesWritten;
+  cMutex metricsMutex; // protects the counters reported by Metrics()
   void GetLastPts(const char *RecordingName);
   bool RunningLowOnDiskSpace(void);
   bool NextFile(void);
   void HandleErrors(bool Force = false);
+  void Put(const uchar *Data, int Length);
+  bool WriteData(const uchar *Data, int Length);
+  void WriteIndex(bool Independent, uint16_t Number, off_t Offset, bool Errors, bool Missing);
+       ///< Writes the given entry to the index file, once the data of the frame
+       ///< has actually been written to the recording file.
+  void FlushIndex(bool Force = false);
+       ///< Writes all pending index entries whose data has been written. If Force
+       ///< is true, waits for all data to be written and writes all pending entries.
 protected:
   virtual void Activate(bool On) override;
        ///< If you override Activate() you need to call Detach() (which is a
@@ -46,6 +64,7 @@ protected:
        ///< to properly get a call to Activate(false) when your object is
        ///< destroyed.
   virtual void Receive(const uchar *Data, int Length) override;
+  virtual void ReceivePackets(const uchar *Data, int Count) override;
   virtual void Action(void) override;
 public:
   cRecorder(const char *FileName, const cChannel *Channel, int Priority);
@@ -60,6 +79,13 @@ public:
        ///< Each frame that is missing or contains (any number of) errors counts as one error.
        ///< If this is a resumed recording, this includes errors that occurred
        ///< in the previous parts.
+  virtual cString Metrics(void) override;
+       ///< Returns the number of bytes written, the maximum fill level of the
+       ///< ring buffer, the number of bytes dropped due to buffer overflows,
+       ///< the number of writes (as well as the number of slow writes and the
+       ///< maximum write time in ms), the number of errors and audio dropouts
+       ///< (as of the last time they were checked), and the name of the recording
+       ///< (in double quotes, with any '"' and '\\' escaped by a backslash).
   };
 
 #endif //__RECORDER_H
@@ -17,6 +17,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include "channels.h"
@@ -463,6 +464,13 @@ void cRecordingInfo::SetAux(const char *Aux)
   aux = Aux ? strdup(Aux) : NULL;
 }
 
+void cRecordingInfo::SetStreamStatistics(const cStringList &StreamStatistics)
+{
+  streamStatistics.Clear();
+  for (int i = 0; i < StreamStatistics.Size(); i++)
+      streamStatistics.Append(strdup(StreamStatistics[i]));
+}
+
 void cRecordingInfo::SetFramesPerSecond(double FramesPerSecond)
 {
   framesPerSecond = FramesPerSecond;
@@ -512,6 +520,7 @@ bool cRecordingInfo::Read(FILE *f, bool Force)
         event = ownEvent = new cEvent(0);
         }
      modified = st.st_mtime;
+     streamStatistics.Clear();
      cReadLine ReadLine;
      char *s;
      int line = 0;
@@ -590,6 +599,8 @@ bool cRecordingInfo::Read(FILE *f, bool Force)
              case '@': free(aux);
                        aux = strdup(t);
                        break;
+             case 'Q': streamStatistics.Append(strdup(t));
+                       break;
              case '#': break; // comments are ignored
              default: if (!ownEvent->Parse(s)) {
                          esyslog("ERROR: EPG data problem in line %d", line);
@@ -618,6 +629,8 @@ bool cRecordingInfo::Write(FILE *f, const char *Prefix) const
   if (tmpErrors)
      fprintf(f, " %d", tmpErrors);
   fprintf(f, "\n");
+  for (int i = 0; i < streamStatistics.Size(); i++)
+      fprintf(f, "%sQ %s\n", Prefix, streamStatistics[i]);
   if (aux)
      fprintf(f, "%s@ %s\n", Prefix, aux);
   return true;
@@ -2594,56 +2607,122 @@ void cRecordingUserCommand::InvokeCommand(const char *State, const char *Recordi
 // --- cIndexFileGenerator ---------------------------------------------------
 
 #define IFG_BUFFER_SIZE KILOBYTE(100)
+#define IFG_MAXPARTS    4 // max. number of TS files that are processed in parallel
+#define IFG_FLUSHWAIT 100 // ms to wait for new entries of the current part
+
+// Since each TS file of a recording starts with an independent frame (see
+// cRecorder::NextFile()), the index of each file can be generated separately.
+// A cIndexFilePart does this for one file and keeps the resulting entries in
+// memory, until cIndexFileGenerator writes them to the index file.
+
+struct tIndexFileEntry {
+  off_t offset;
+  bool independent;
+  bool errors;
+  bool missing;
+  };
 
-class cIndexFileGenerator : public cThread {
+class cIndexFilePart : public cThread {
 private:
   cString recordingName;
-  bool update;
+  int number;
+  cMutex mutex;
+  tIndexFileEntry *entries;
+  int numEntries;
+  int allocated;
+  int flushed;
+  off_t bytes;
+  bool done; // protected by mutex, just like the entries, since it is polled by the generator thread
+  cFrameDetector frameDetector;
+  void Add(bool Independent, off_t Offset, bool Errors, bool Missing);
 protected:
   virtual void Action(void) override;
 public:
-  cIndexFileGenerator(const char *RecordingName);
-  ~cIndexFileGenerator();
+  cIndexFilePart(const char *RecordingName, int Number);
+  virtual ~cIndexFilePart() override;
+  int Number(void) { return number; }
+  bool Done(void) { cMutexLock MutexLock(&mutex); return done; }
+       ///< Returns true if this file has been processed entirely.
+  int Flush(cIndexFile &IndexFile);
+       ///< Writes all entries that have been generated since the last call to
+       ///< IndexFile and returns their number.
+  int Frames(void) { return flushed; }
+  off_t Bytes(void) { cMutexLock MutexLock(&mutex); return bytes; }
+  cFrameDetector *FrameDetector(void) { return Done() ? &frameDetector : NULL; }
   };
 
-cIndexFileGenerator::cIndexFileGenerator(const char *RecordingName)
-:cThread("index file generator")
+cIndexFilePart::cIndexFilePart(const char *RecordingName, int Number)
+:cThread("index file part")
 ,recordingName(RecordingName)
 {
+  number = Number;
+  entries = NULL;
+  numEntries = 0;
+  allocated = 0;
+  flushed = 0;
+  bytes = 0;
+  done = false;
+  SetDescription("index file part %d", number);
   Start();
 }
 
-cIndexFileGenerator::~cIndexFileGenerator()
+cIndexFilePart::~cIndexFilePart()
 {
   Cancel(3);
+  free(entries);
 }
 
-void cIndexFileGenerator::Action(void)
+void cIndexFilePart::Add(bool Independent, off_t Offset, bool Errors, bool Missing)
+{
+  cMutexLock MutexLock(&mutex);
+  if (numEntries >= allocated) {
+     int NewAllocated = allocated ? 2 * allocated : 1024;
+     if (tIndexFileEntry *NewEntries = (tIndexFileEntry *)realloc(entries, NewAllocated * sizeof(tIndexFileEntry))) {
+        entries = NewEntries;
+        allocated = NewAllocated;
+        }
+     else {
+        esyslog("ERROR: can't realloc() index file part %d", number);
+        return;
+        }
+     }
+  tIndexFileEntry *e = &entries[numEntries++];
+  e->offset = Offset;
+  e->independent = Independent;
+  e->errors = Errors;
+  e->missing = Missing;
+}
+
+int cIndexFilePart::Flush(cIndexFile &IndexFile)
+{
+  cMutexLock MutexLock(&mutex);
+  int n = numEntries - flushed;
+  for ( ; flushed < numEntries; flushed++) {
+      tIndexFileEntry *e = &entries[flushed];
+      IndexFile.Write(e->independent, uint16_t(number), e->offset, e->errors, e->missing);
+      }
+  return n;
+}
+
+void cIndexFilePart::Action(void)
 {
-  bool IndexFileComplete = false;
-  bool IndexFileWritten = false;
   bool Rewind = false;
   cFileName FileName(recordingName, false);
-  cUnbufferedFile *ReplayFile = FileName.Open();
+  cUnbufferedFile *ReplayFile = FileName.SetOffset(number);
   cRingBufferLinear Buffer(IFG_BUFFER_SIZE, MIN_TS_PACKETS_FOR_FRAME_DETECTOR * TS_SIZE);
   cPatPmtParser PatPmtParser;
-  cFrameDetector FrameDetector;
-  cIndexFile IndexFile(recordingName, true);
   int BufferChunks = KILOBYTE(1); // no need to read a lot at the beginning when parsing PAT/PMT
   off_t FileSize = 0;
   off_t FrameOffset = -1;
   bool pendIndependentFrame = false;
-  uint16_t pendNumber = 0;
   off_t pendFileSize = 0;
   bool pendMissing = false;
-  int Errors = 0;
-  Skins.QueueMessage(mtInfo, tr("Regenerating index file"));
-  SetRecordingTimerId(recordingName, cString::sprintf("%d@%s", 0, Setup.SVDRPHostName));
+  bool pending = false;
   bool Stuffed = false;
   while (Running()) {
         // Rewind input file:
         if (Rewind) {
-           ReplayFile = FileName.SetOffset(1);
+           ReplayFile = FileName.SetOffset(number);
            Buffer.Clear();
            Rewind = false;
            }
@@ -2651,7 +2730,7 @@ void cIndexFileGenerator::Action(void)
         int Length;
         uchar *Data = Buffer.Get(Length);
         if (Data) {
-           if (FrameDetector.Synced()) {
+           if (frameDetector.Synced()) {
               // Step 3 - generate the index:
               if (TsPid(Data) == PATPID) {
                  int OldPatVersion, OldPmtVersion;
@@ -2661,26 +2740,24 @@ void cIndexFileGenerator::Action(void)
                     if (PatPmtParser.GetVersions(NewPatVersion, NewPmtVersion)) {
                        if (NewPatVersion != OldPatVersion || NewPmtVersion != OldPmtVersion) {
                           dsyslog("PAT/PMT version change while generating index");
-                          FrameDetector.SetPid(PatPmtParser.Vpid() ? PatPmtParser.Vpid() : PatPmtParser.Apid(0), PatPmtParser.Vpid() ? PatPmtParser.Vtype() : PatPmtParser.Atype(0));
+                          frameDetector.SetPid(PatPmtParser.Vpid() ? PatPmtParser.Vpid() : PatPmtParser.Apid(0), PatPmtParser.Vpid() ? PatPmtParser.Vtype() : PatPmtParser.Atype(0));
                           }
                        }
                     }
                  FrameOffset = FileSize; // the PAT/PMT is at the beginning of an I-frame
                  }
-              int Processed = FrameDetector.Analyze(Data, Length);
+              int Processed = frameDetector.Analyze(Data, Length);
               if (Processed > 0) {
                  bool PreviousErrors = false;
                  bool MissingFrames = false;
-                 if (FrameDetector.NewFrame(PreviousErrors, MissingFrames)) {
-                    if (pendNumber > 0)
-                       IndexFile.Write(pendIndependentFrame, pendNumber, pendFileSize, PreviousErrors, pendMissing);
-                    pendIndependentFrame = FrameDetector.IndependentFrame();
-                    pendNumber = FileName.Number();
+                 if (frameDetector.NewFrame(PreviousErrors, MissingFrames)) {
+                    if (pending)
+                       Add(pendIndependentFrame, pendFileSize, PreviousErrors, pendMissing);
+                    pendIndependentFrame = frameDetector.IndependentFrame();
                     pendFileSize = FrameOffset >= 0 ? FrameOffset : FileSize;
                     pendMissing = MissingFrames;
+                    pending = true;
                     FrameOffset = -1;
-                    IndexFileWritten = true;
-                    Errors = FrameDetector.Errors();
                     }
                  FileSize += Processed;
                  Buffer.Del(Processed);
@@ -2688,9 +2765,9 @@ void cIndexFileGenerator::Action(void)
               }
            else if (PatPmtParser.Completed()) {
               // Step 2 - sync FrameDetector:
-              int Processed = FrameDetector.Analyze(Data, Length, false);
+              int Processed = frameDetector.Analyze(Data, Length, false);
               if (Processed > 0) {
-                 if (FrameDetector.Synced()) {
+                 if (frameDetector.Synced()) {
                     // Synced FrameDetector, so rewind for actual processing:
                     Rewind = true;
                     }
@@ -2710,7 +2787,7 @@ void cIndexFileGenerator::Action(void)
                     p += TS_SIZE;
                     if (PatPmtParser.Completed()) {
                        // Found pid, so rewind to sync FrameDetector:
-                       FrameDetector.SetPid(PatPmtParser.Vpid() ? PatPmtParser.Vpid() : PatPmtParser.Apid(0), PatPmtParser.Vpid() ? PatPmtParser.Vtype() : PatPmtParser.Atype(0));
+                       frameDetector.SetPid(PatPmtParser.Vpid() ? PatPmtParser.Vpid() : PatPmtParser.Apid(0), PatPmtParser.Vpid() ? PatPmtParser.Vtype() : PatPmtParser.Atype(0));
                        BufferChunks = IFG_BUFFER_SIZE;
                        Rewind = true;
                        break;
@@ -2735,38 +2812,131 @@ void cIndexFileGenerator::Action(void)
                      Buffer.Put(StuffingPacket, sizeof(StuffingPacket));
                  Stuffed = true;
                  }
+              else if (frameDetector.Synced())
+                 ReplayFile = NULL; // this file has been processed
               else {
+                 // Syncing may need data from the following files, which is only
+                 // used for that purpose, since we rewind to our own file afterwards:
                  ReplayFile = FileName.NextFile();
-                 FileSize = 0;
-                 FrameOffset = -1;
                  Buffer.Clear();
                  Stuffed = false;
                  }
               }
            }
-        // Recording has been processed:
+        // File has been processed:
         else {
            bool PreviousErrors = false;
            bool MissingFrames = false;
-           Errors = FrameDetector.Errors(&PreviousErrors, &MissingFrames);
-           if (pendNumber > 0)
-              IndexFile.Write(pendIndependentFrame, pendNumber, pendFileSize, PreviousErrors, pendMissing || MissingFrames);
+           frameDetector.Errors(&PreviousErrors, &MissingFrames);
+           if (pending)
+              Add(pendIndependentFrame, pendFileSize, PreviousErrors, pendMissing || MissingFrames);
+           cMutexLock MutexLock(&mutex);
+           bytes = FileSize;
+           done = true;
+           break;
+           }
+        }
+}
+
+class cIndexFileGenerator : public cThread {
+private:
+  cString recordingName;
+  bool update;
+protected:
+  virtual void Action(void) override;
+public:
+  cIndexFileGenerator(const char *RecordingName);
+  ~cIndexFileGenerator();
+  };
+
+cIndexFileGenerator::cIndexFileGenerator(const char *RecordingName)
+:cThread("index file generator")
+,recordingName(RecordingName)
+{
+  Start();
+}
+
+cIndexFileGenerator::~cIndexFileGenerator()
+{
+  Cancel(3);
+}
+
+void cIndexFileGenerator::Action(void)
+{
+  bool IndexFileComplete = false;
+  bool IndexFileWritten = false;
+  cFileName FileName(recordingName, false);
+  cIndexFile IndexFile(recordingName, true);
+  cVector<cIndexFilePart *> Parts; // the files currently being processed, in ascending order
+  int NextNumber = 1;
+  bool MoreFiles = true;
+  int MaxParts = 0; // the max. number of files that have actually been processed in parallel
+  int Errors = 0;
+  int Frames = 0;
+  off_t Bytes = 0;
+  double FramesPerSecond = 0;
+  uint16_t FrameWidth = 0;
+  uint16_t FrameHeight = 0;
+  eScanType ScanType = stUnknown;
+  eAspectRatio AspectRatio = arUnknown;
+  cTimeMs Timer;
+  Skins.QueueMessage(mtInfo, tr("Regenerating index file"));
+  SetRecordingTimerId(recordingName, cString::sprintf("%d@%s", 0, Setup.SVDRPHostName));
+  while (Running()) {
+        // Start processing further files:
+        while (MoreFiles && Parts.Size() < IFG_MAXPARTS) {
+              if (FileName.SetOffset(NextNumber))
+                 Parts.Append(new cIndexFilePart(recordingName, NextNumber++));
+              else
+                 MoreFiles = false;
+              FileName.Close();
+              }
+        MaxParts = max(MaxParts, Parts.Size());
+        // Recording has been processed:
+        if (Parts.Size() == 0) {
            IndexFileComplete = true;
            break;
            }
+        // Write the entries of the first file (in the order of the files):
+        cIndexFilePart *Part = Parts[0];
+        bool Done = Part->Done(); // must be checked before flushing, so that no entries are lost
+        if (Part->Flush(IndexFile) > 0)
+           IndexFileWritten = true;
+        if (Done) {
+           cFrameDetector *FrameDetector = Part->FrameDetector();
+           Errors += FrameDetector->Errors();
+           if (FrameDetector->FramesPerSecond() > 0) {
+              FramesPerSecond = FrameDetector->FramesPerSecond();
+              FrameWidth = FrameDetector->FrameWidth();
+              FrameHeight = FrameDetector->FrameHeight();
+              ScanType = FrameDetector->ScanType();
+              AspectRatio = FrameDetector->AspectRatio();
+              }
+           Frames += Part->Frames();
+           Bytes += Part->Bytes();
+           dsyslog("index file generator: file %d of '%s' done (%d frames, %" PRId64 " bytes)", Part->Number(), *recordingName, Part->Frames(), Part->Bytes());
+           delete Part;
+           Parts.Remove(0);
+           }
+        else
+           cCondWait::SleepMs(IFG_FLUSHWAIT);
         }
+  for (int i = 0; i < Parts.Size(); i++)
+      delete Parts[i];
   SetRecordingTimerId(recordingName, NULL);
   if (IndexFileComplete) {
+     int Elapsed = max(int(Timer.Elapsed()), 1);
+     dsyslog("index file generator: %d frames, %d MB in %.1fs (%.1f MB/s, %d threads)", Frames, int(Bytes / MEGABYTE(1)), Elapsed / 1000.0, double(Bytes) / MEGABYTE(1) * 1000 / Elapsed, MaxParts);
      if (IndexFileWritten) {
         cRecordingInfo RecordingInfo(recordingName);
         if (RecordingInfo.Read()) {
-           if ((FrameDetector.FramesPerSecond() > 0 && !DoubleEqual(RecordingInfo.FramesPerSecond(), FrameDetector.FramesPerSecond())) ||
-               FrameDetector.FrameWidth()  != RecordingInfo.FrameWidth()  ||
-               FrameDetector.FrameHeight() != RecordingInfo.FrameHeight() ||
-               FrameDetector.AspectRatio() != RecordingInfo.AspectRatio() ||
+           if ((FramesPerSecond > 0 && !DoubleEqual(RecordingInfo.FramesPerSecond(), FramesPerSecond)) ||
+               FrameWidth  != RecordingInfo.FrameWidth()  ||
+               FrameHeight != RecordingInfo.FrameHeight() ||
+               AspectRatio != RecordingInfo.AspectRatio() ||
                Errors != RecordingInfo.Errors()) {
-              RecordingInfo.SetFramesPerSecond(FrameDetector.FramesPerSecond());
-              RecordingInfo.SetFrameParams(FrameDetector.FrameWidth(), FrameDetector.FrameHeight(), FrameDetector.ScanType(), FrameDetector.AspectRatio());
+              RecordingInfo.SetFramesPerSecond(FramesPerSecond);
+              RecordingInfo.SetFrameParams(FrameWidth, FrameHeight, ScanType, AspectRatio);
               RecordingInfo.SetErrors(Errors);
               RecordingInfo.Write();
               LOCK_RECORDINGS_WRITE;
@@ -2828,6 +2998,8 @@ cIndexFile::cIndexFile(const char *FileName, bool Record, bool IsPesRecording, b
   last = -1;
   lastErrorIndex = last;
   index = NULL;
+  mapped = false;
+  iFramesLast = -1;
   isPesRecording = IsPesRecording;
   indexFileGenerator = NULL;
   if (FileName) {
@@ -2862,30 +3034,45 @@ cIndexFile::cIndexFile(const char *FileName, bool Record, bool IsPesRecording, b
            last = int((buf.st_size + delta) / sizeof(tIndexTs) - 1);
            if (!Record && last >= 0) {
               size = last + 1;
-              index = MALLOC(tIndexTs, size);
-              if (index) {
-                 f = open(fileName, O_RDONLY);
-                 if (f >= 0) {
-                    if (safe_read(f, index, size_t(buf.st_size)) != buf.st_size) {
-                       esyslog("ERROR: can't read from file '%s'", *fileName);
-                       free(index);
-                       size = 0;
-                       last = -1;
-                       index = NULL;
+              f = open(fileName, O_RDONLY);
+              if (f >= 0) {
+                 if (!isPesRecording && !delta) {
+                    // TS index files are mapped into memory, so that all readers of the same
+                    // recording share the same pages:
+                    void *p = mmap(NULL, size * sizeof(tIndexTs), PROT_READ, MAP_SHARED, f, 0);
+                    if (p != MAP_FAILED) {
+                       index = (tIndexTs *)p;
+                       mapped = true;
                        }
-                    else if (isPesRecording)
-                       ConvertFromPes(index, size);
-                    if (!index || !StillRecording(FileName)) {
-                       close(f);
-                       f = -1;
+                    else
+                       LOG_ERROR_STR(*fileName); // falls back to reading the index into memory
+                    }
+                 if (!mapped) {
+                    index = MALLOC(tIndexTs, size);
+                    if (index) {
+                       if (safe_read(f, index, size_t(buf.st_size)) != buf.st_size) {
+                          esyslog("ERROR: can't read from file '%s'", *fileName);
+                          free(index);
+                          index = NULL;
+                          }
+                       else if (isPesRecording)
+                          ConvertFromPes(index, size);
                        }
-                    // otherwise we don't close f here, see CatchUp()!
+                    else
+                       esyslog("ERROR: can't allocate %zd bytes for index '%s'", size * sizeof(tIndexTs), *fileName);
                     }
-                 else
-                    LOG_ERROR_STR(*fileName);
+                 if (!index) {
+                    size = 0;
+                    last = -1;
+                    }
+                 if (!index || !StillRecording(FileName)) {
+                    close(f);
+                    f = -1;
+                    }
+                 // otherwise we don't close f here, see CatchUp()!
                  }
               else {
-                 esyslog("ERROR: can't allocate %zd bytes for index '%s'", size * sizeof(tIndexTs), *fileName);
+                 LOG_ERROR_STR(*fileName);
                  size = 0;
                  last = -1;
                  }
@@ -2914,7 +3101,10 @@ cIndexFile::~cIndexFile()
 {
   if (f >= 0)
      close(f);
-  free(index);
+  if (mapped)
+     munmap(index, size * sizeof(tIndexTs));
+  else
+     free(index);
   delete indexFileGenerator;
 }
 
@@ -2948,6 +3138,30 @@ void cIndexFile::ConvertToPes(tIndexTs *IndexTs, int Count)
         }
 }
 
+void cIndexFile::UpdateIFrames(void)
+{
+  for ( ; iFramesLast < last; iFramesLast++) {
+      if (index[iFramesLast + 1].independent)
+         iFrames.Append(iFramesLast + 1);
+      }
+}
+
+int cIndexFile::FindIFrame(int Index)
+{
+  cMutexLock MutexLock(&mutex); // iFrames may be extended by several threads
+  UpdateIFrames();
+  int l = 0;
+  int h = iFrames.Size();
+  while (l < h) {
+        int m = (l + h) / 2;
+        if (iFrames[m] < Index)
+           l = m + 1;
+        else
+           h = m;
+        }
+  return l;
+}
+
 bool cIndexFile::CatchUp(int Index)
 {
   // returns true unless something really goes wrong, so that 'index' becomes NULL
@@ -2966,7 +3180,21 @@ bool cIndexFile::CatchUp(int Index)
                   if (NewSize <= newLast)
                      NewSize = newLast + 1;
                   }
-               if (tIndexTs *NewBuffer = (tIndexTs *)realloc(index, NewSize * sizeof(tIndexTs))) {
+               if (mapped) {
+                  // The mapping may extend beyond the end of the file, pages there become
+                  // accessible as the file grows:
+                  if (NewSize > size) {
+                     void *p = mremap(index, size * sizeof(tIndexTs), NewSize * sizeof(tIndexTs), MREMAP_MAYMOVE);
+                     if (p == MAP_FAILED) {
+                        LOG_ERROR_STR(*fileName);
+                        break;
+                        }
+                     size = NewSize;
+                     index = (tIndexTs *)p;
+                     }
+                  last = newLast;
+                  }
+               else if (tIndexTs *NewBuffer = (tIndexTs *)realloc(index, NewSize * sizeof(tIndexTs))) {
                   size = NewSize;
                   index = NewBuffer;
                   int offset = (last + 1) * sizeof(tIndexTs);
@@ -3065,37 +3293,37 @@ const cErrors *cIndexFile::GetErrors(void)
 int cIndexFile::GetNextIFrame(int Index, bool Forward, uint16_t *FileNumber, off_t *FileOffset, int *Length)
 {
   if (CatchUp()) {
-     int d = Forward ? 1 : -1;
-     for (;;) {
-         Index += d;
-         if (Index >= 0 && Index <= last) {
-            if (index[Index].independent) {
-               uint16_t fn;
-               if (!FileNumber)
-                  FileNumber = &fn;
-               off_t fo;
-               if (!FileOffset)
-                  FileOffset = &fo;
-               *FileNumber = index[Index].number;
-               *FileOffset = index[Index].offset;
-               if (Length) {
-                  if (Index < last) {
-                     uint16_t fn = index[Index + 1].number;
-                     off_t fo = index[Index + 1].offset;
-                     if (fn == *FileNumber)
-                        *Length = int(fo - *FileOffset);
-                     else
-                        *Length = -1; // this means "everything up to EOF" (the buffer's Read function will act accordingly)
-                     }
-                  else
-                     *Length = -1;
-                  }
-               return Index;
-               }
-            }
-         else
-            break;
-         }
+     cMutexLock MutexLock(&mutex);
+     Index += Forward ? 1 : -1;
+     if (Index >= 0 && Index <= last) {
+        int i = FindIFrame(Index); // the first I-frame at or after Index
+        if (!Forward && (i >= iFrames.Size() || iFrames[i] > Index))
+           i--;
+        if (i >= 0 && i < iFrames.Size()) {
+           Index = iFrames[i];
+           uint16_t fn;
+           if (!FileNumber)
+              FileNumber = &fn;
+           off_t fo;
+           if (!FileOffset)
+              FileOffset = &fo;
+           *FileNumber = index[Index].number;
+           *FileOffset = index[Index].offset;
+           if (Length) {
+              if (Index < last) {
+                 uint16_t fn = index[Index + 1].number;
+                 off_t fo = index[Index + 1].offset;
+                 if (fn == *FileNumber)
+                    *Length = int(fo - *FileOffset);
+                 else
+                    *Length = -1; // this means "everything up to EOF" (the buffer's Read function will act accordingly)
+                 }
+              else
+                 *Length = -1;
+              }
+           return Index;
+           }
+        }
      }
   return -1;
 }
@@ -3103,27 +3331,17 @@ int cIndexFile::GetNextIFrame(int Index, bool Forward, uint16_t *FileNumber, off
 int cIndexFile::GetClosestIFrame(int Index)
 {
   if (index && last > 0) {
+     cMutexLock MutexLock(&mutex);
      Index = constrain(Index, 0, last);
-     if (index[Index].independent)
+     int i = FindIFrame(Index); // the first I-frame at or after Index
+     int ih = i < iFrames.Size() ? iFrames[i] : -1;
+     if (ih == Index)
         return Index;
-     int il = Index - 1;
-     int ih = Index + 1;
-     for (;;) {
-         if (il >= 0) {
-            if (index[il].independent)
-               return il;
-            il--;
-            }
-         else if (ih > last)
-            break;
-         if (ih <= last) {
-            if (index[ih].independent)
-               return ih;
-            ih++;
-            }
-         else if (il < 0)
-            break;
-         }
+     int il = i > 0 ? iFrames[i - 1] : -1;
+     if (il >= 0 && (ih < 0 || Index - il <= ih - Index))
+        return il;
+     if (ih >= 0)
+        return ih;
      }
   return 0;
 }
@@ -3131,13 +3349,17 @@ int cIndexFile::GetClosestIFrame(int Index)
 int cIndexFile::Get(uint16_t FileNumber, off_t FileOffset)
 {
   if (CatchUp()) {
-     //TODO implement binary search!
-     int i;
-     for (i = 0; i <= last; i++) {
-         if (index[i].number > FileNumber || (index[i].number == FileNumber) && off_t(index[i].offset) >= FileOffset)
-            break;
-         }
-     return i;
+     // Binary search for the first frame at or after the given position:
+     int l = 0;
+     int h = last + 1;
+     while (l < h) {
+           int m = (l + h) / 2;
+           if (index[m].number < FileNumber || index[m].number == FileNumber && off_t(index[m].offset) < FileOffset)
+              l = m + 1;
+           else
+              h = m;
+           }
+     return l;
      }
   return -1;
 }
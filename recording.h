@@ -80,6 +80,7 @@ private:
   char *fileName;
   int errors;
   int tmpErrors;
+  cStringList streamStatistics;
   cRecordingInfo(const cChannel *Channel = NULL, const cEvent *Event = NULL);
   bool Read(FILE *f, bool Force = false);
 public:
@@ -111,6 +112,10 @@ public:
   int Errors(void) const { return errors; } // returns -1 if undefined
   int TmpErrors(void) const { return tmpErrors; } // returns -1 if undefined
   void SetErrors(int Errors, int TmpErrors = 0);
+  const cStringList &StreamStatistics(void) const { return streamStatistics; }
+       ///< Returns the statistics of the elementary streams, as determined while
+       ///< recording, one line per stream (see cStreamStatistics::InfoString()).
+  void SetStreamStatistics(const cStringList &StreamStatistics);
   bool Write(FILE *f, const char *Prefix = "") const;
   bool Read(bool Force = false);
   bool Write(void) const;
@@ -489,6 +494,7 @@ public:
 #define MAXVIDEOFILESIZEPES    2000 // MB
 #define MINVIDEOFILESIZE        100 // MB
 #define MAXVIDEOFILESIZEDEFAULT MAXVIDEOFILESIZEPES
+#define MAXWRITEBUFFERSIZE       64 // MB
 
 struct tIndexTs;
 class cIndexFileGenerator;
@@ -500,6 +506,9 @@ private:
   int size, last;
   int lastErrorIndex;
   tIndexTs *index;
+  bool mapped; // index is a read-only memory mapping of the index file
+  cVector<int> iFrames; // the indexes of all independent frames up to iFramesLast, in ascending order
+  int iFramesLast;
   bool isPesRecording;
   cResumeFile resumeFile;
   cErrors errors;
@@ -508,6 +517,14 @@ private:
   void ConvertFromPes(tIndexTs *IndexTs, int Count);
   void ConvertToPes(tIndexTs *IndexTs, int Count);
   bool CatchUp(int Index = -1);
+  void UpdateIFrames(void);
+       ///< Adds the independent frames from iFramesLast up to the last entry of the index to
+       ///< iFrames. This is done only when iFrames is actually needed, so that users of the
+       ///< index that don't care about independent frames don't have to scan it.
+       ///< Must be called with mutex locked.
+  int FindIFrame(int Index);
+       ///< Returns the position in iFrames of the first independent frame at or after Index
+       ///< (iFrames.Size() if there is none).
 public:
   cIndexFile(const char *FileName, bool Record, bool IsPesRecording = false, bool PauseLive = false);
   [[deprecated("use cIndexFile(::cIndexFile(const char *, bool, bool, bool) instead")]]
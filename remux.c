@@ -144,13 +144,34 @@ void TsSetPcr(uchar *p, int64_t Pcr)
      }
 }
 
+int TsPidRun(const uchar *Data, int Count, bool *Scrambled)
+{
+  uint32_t First = TsHeader(Data) & TS_HEADER_SYNC_PID;
+  uint32_t Flags = 0;
+  int n = 0;
+  while (n < Count) {
+        uint32_t Header = TsHeader(Data);
+        if ((Header & TS_HEADER_SYNC_PID) != First)
+           break;
+        Flags |= Header;
+        Data += TS_SIZE;
+        n++;
+        }
+  if (Scrambled)
+     *Scrambled = Flags & TS_SCRAMBLING_CONTROL;
+  return n;
+}
+
 int TsSync(const uchar *Data, int Length, const char *File, const char *Function, int Line)
 {
   int Skipped = 0;
   while (Length > 0 && (*Data != TS_SYNC_BYTE || Length > TS_SIZE && Data[TS_SIZE] != TS_SYNC_BYTE)) {
-        Data++;
-        Length--;
-        Skipped++;
+        // Let memchr() (which is heavily optimized) find the next candidate:
+        const uchar *p = (const uchar *)memchr(Data + 1, TS_SYNC_BYTE, Length - 1);
+        int d = p ? p - Data : Length;
+        Data += d;
+        Length -= d;
+        Skipped += d;
         }
   if (Skipped && File && Function && Line)
      esyslog("ERROR: skipped %d bytes to sync on start of TS packet at %s/%s(%d)", Skipped, File, Function, Line);
@@ -317,6 +338,32 @@ bool cTsPayload::SkipBytes(int Bytes)
   return !Eof();
 }
 
+void cTsPayload::SkipToStartCode(uint32_t &Scanner)
+{
+  if (Eof() || index % TS_SIZE == 0 || (Scanner & 0x00FFFFFF) == 0x000001)
+     return;
+  int Last = index - index % TS_SIZE + TS_SIZE - 1; // the last byte of the current TS packet
+  int i = index;
+  while (i < Last) {
+        // Let memchr() (which is heavily optimized) find the next candidate:
+        const uchar *p = (const uchar *)memchr(data + i, 0x01, Last - i);
+        if (!p) {
+           i = Last;
+           break;
+           }
+        int m = p - data;
+        i = m + 1;
+        // The two bytes before the 0x01 may already have been shifted into Scanner:
+        uchar b1 = m - 1 >= index ? data[m - 1] : uchar(Scanner);
+        uchar b2 = m - 2 >= index ? data[m - 2] : uchar(Scanner >> (m - 1 >= index ? 0 : 8));
+        if (b1 == 0x00 && b2 == 0x00)
+           break;
+        }
+  for (int j = max(index, i - 4); j < i; j++)
+      Scanner = (Scanner << 8) | data[j];
+  index = i;
+}
+
 bool cTsPayload::SkipPesHeader(void)
 {
   return SkipBytes(PesPayloadOffset(data + TsPayloadOffset(data)));
@@ -1287,6 +1334,7 @@ int cMpeg2Parser::Parse(const uchar *Data, int Length, int Pid)
   for (;;) {
       if (!SeenPayloadStart && tsPayload.AtTsStart())
          OldScanner = scanner;
+      tsPayload.SkipToStartCode(scanner);
       scanner = (scanner << 8) | tsPayload.GetByte();
       if (scanner == 0x00000100) { // Picture Start Code
          if (!SeenPayloadStart && tsPayload.GetLastIndex() > TS_SIZE) {
@@ -1479,6 +1527,7 @@ int cH264Parser::Parse(const uchar *Data, int Length, int Pid)
         }
      }
   for (;;) {
+      tsPayload.SkipToStartCode(scanner);
       scanner = (scanner << 8) | GetByte(true);
       if ((scanner & 0xFFFFFF00) == 0x00000100) { // NAL unit start
          uchar NalUnitType = scanner & 0x1F;
@@ -1714,6 +1763,7 @@ int cH265Parser::Parse(const uchar *Data, int Length, int Pid)
      scanner = EMPTY_SCANNER;
      }
   for (;;) {
+      tsPayload.SkipToStartCode(scanner);
       scanner = (scanner << 8) | GetByte(true);
       if ((scanner & 0xFFFFFF00) == 0x00000100) { // NAL unit start
          uchar NalUnitType = (scanner >> 1) & 0x3F;
@@ -2157,6 +2207,117 @@ int cFrameChecker::TotalErrors(void)
   return tsChecker->Errors() + ptsChecker->Missing();
 }
 
+// --- cStreamStatistics -----------------------------------------------------
+
+#define MAXPTSGAP (10 * PTSTICKS) // PTS jumps larger than this are considered discontinuities
+
+cStreamStatistics::cStreamStatistics(int Pid, int Type)
+{
+  pid = Pid;
+  type = Type;
+  isVideo = type == 0x01 || type == 0x02 || type == 0x1B || type == 0x24; // MPEG 1, 2, H.264 or H.265
+  cc = -1;
+  packets = 0;
+  bytes = 0;
+  ccErrors = 0;
+  payloadUnits = 0;
+  firstPts = maxPts = lastPts = -1;
+  duration = 0;
+  frameDelta = 0;
+  esBytes = lastEsBytes = 0;
+  esErrors = lastEsErrors = false;
+  ticksPerByte = 0;
+  dropouts = 0;
+  dropoutTicks = 0;
+  discontinuities = 0;
+}
+
+void cStreamStatistics::Process(const uchar *Data)
+{
+  packets++;
+  bytes += TS_SIZE;
+  int Cc = TsContinuityCounter(Data);
+  if (cc >= 0 && Cc != ((cc + 1) & TS_CONT_CNT_MASK)) {
+     ccErrors++;
+     esErrors = true; // in case of a payload start, this affects the previous payload unit
+     }
+  cc = Cc;
+  const uchar *Payload = Data;
+  int Length = TsGetPayload(&Payload);
+  if (TsPayloadStart(Data)) {
+     payloadUnits++;
+     lastEsBytes = esBytes;
+     lastEsErrors = esErrors;
+     esBytes = Length >= 9 ? max(Length - PesPayloadOffset(Payload), 0) : 0;
+     esErrors = false;
+     int64_t Pts = TsGetPts(Data, TS_SIZE);
+     if (Pts >= 0) {
+        if (lastPts >= 0) {
+           int64_t d = PtsDiff(lastPts, Pts);
+           if (d > MAXPTSGAP || d < (isVideo ? -MAXPTSGAP : 0)) { // video frames are not transmitted in presentation order
+              discontinuities++;
+              duration += PtsDiff(firstPts, maxPts);
+              firstPts = maxPts = Pts;
+              }
+           else {
+              if (d > 0) {
+                 if (!frameDelta || d < frameDelta)
+                    frameDelta = d;
+                 if (!isVideo && lastEsBytes > 0 && !lastEsErrors) {
+                    double Ratio = double(d) / lastEsBytes;
+                    if (!ticksPerByte || Ratio < ticksPerByte)
+                       ticksPerByte = Ratio;
+                    else {
+                       // A dropout is at least one frame, and frameDelta is at most one frame:
+                       double Expected = lastEsBytes * ticksPerByte;
+                       if (d > frameDelta + frameDelta / 2 && d > Expected + frameDelta / 2) {
+                          dropouts++;
+                          dropoutTicks += int64_t(d - Expected);
+                          }
+                       }
+                    }
+                 }
+              if (PtsDiff(maxPts, Pts) > 0)
+                 maxPts = Pts;
+              }
+           }
+        else
+           firstPts = maxPts = Pts;
+        lastPts = Pts;
+        }
+     }
+  else
+     esBytes += Length;
+}
+
+double cStreamStatistics::Duration(void) const
+{
+  int64_t d = duration;
+  if (firstPts >= 0)
+     d += PtsDiff(firstPts, maxPts);
+  return double(d) / PTSTICKS;
+}
+
+int cStreamStatistics::Bitrate(void) const
+{
+  double d = Duration();
+  return d > 0 ? int(bytes * 8 / d) : 0;
+}
+
+cString cStreamStatistics::ToString(void) const
+{
+  return cString::sprintf("PID %d (type 0x%02X): %d kbit/s, %.2f fps, %d dropout%s (%.2fs), %d discontinuit%s, %d continuity error%s",
+           pid, type, Bitrate() / 1000, FramesPerSecond(),
+           dropouts, dropouts == 1 ? "" : "s", DropoutTime(),
+           discontinuities, discontinuities == 1 ? "y" : "ies",
+           ccErrors, ccErrors == 1 ? "" : "s");
+}
+
+cString cStreamStatistics::InfoString(void) const
+{
+  return cString::sprintf("%d %d %d %s %d %s %d %d", pid, type, Bitrate(), *dtoa(FramesPerSecond(), "%.2f"), dropouts, *dtoa(DropoutTime(), "%.2f"), discontinuities, ccErrors);
+}
+
 // --- cFrameDetector --------------------------------------------------------
 
 const char *ScanTypeChars = "-pi";  // index is eScanType
@@ -2195,6 +2356,8 @@ cFrameDetector::~cFrameDetector()
 {
   delete ptsChecker;
   delete tsChecker;
+  for (int i = 0; i < streams.Size(); i++)
+      delete streams[i];
 }
 
 static int CmpUint32(const void *p1, const void *p2)
@@ -2224,6 +2387,32 @@ void cFrameDetector::SetPid(int Pid, int Type)
   tsChecker->Reset();
 }
 
+void cFrameDetector::AddStream(int Pid, int Type)
+{
+  if (Pid == pid)
+     return;
+  for (int i = 0; i < streams.Size(); i++) {
+      if (streams[i]->Pid() == Pid)
+         return;
+      }
+  streams.Append(new cStreamStatistics(Pid, Type));
+}
+
+void cFrameDetector::ProcessStreams(const uchar *Data, int Length)
+{
+  for ( ; Length >= TS_SIZE && *Data == TS_SYNC_BYTE; Data += TS_SIZE, Length -= TS_SIZE) {
+      if (TsHasPayload(Data) && !TsIsScrambled(Data)) {
+         int Pid = TsPid(Data);
+         for (int i = 0; i < streams.Size(); i++) {
+             if (streams[i]->Pid() == Pid) {
+                streams[i]->Process(Data);
+                break;
+                }
+             }
+         }
+      }
+}
+
 void cFrameDetector::SetLastPts(int64_t LastPts)
 {
   ptsChecker->AddPts(LastPts);
@@ -2388,6 +2577,8 @@ int cFrameDetector::Analyze(const uchar *Data, int Length, bool ErrorCheck)
               }
            tsChecker->CheckTs(Data, Handled);
            }
+        if (streams.Size())
+           ProcessStreams(Data, Handled); // the parser may have handled packets of other PIDs, too
         Data += Handled;
         Length -= Handled;
         Processed += Handled;
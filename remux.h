@@ -105,6 +105,19 @@ inline void TsSetContinuityCounter(uchar *p, uchar Counter)
   p[3] = (p[3] & ~TS_CONT_CNT_MASK) | (Counter & TS_CONT_CNT_MASK);
 }
 
+inline uint32_t TsHeader(const uchar *p)
+{
+  return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+#define TS_HEADER_SYNC_PID 0xFF1FFF00 // sync byte and PID in the value returned by TsHeader()
+
+int TsPidRun(const uchar *Data, int Count, bool *Scrambled = NULL);
+     ///< Returns the number of consecutive TS packets (at most Count) at Data that start
+     ///< with a sync byte and have the same PID as the first one. Data must point to the
+     ///< sync byte of a TS packet. If Scrambled is given, it is set to true if any of these
+     ///< packets is scrambled.
+
 inline int TsPayloadOffset(const uchar *p)
 {
   int o = TsHasAdaptationField(p) ? p[4] + 5 : 4;
@@ -270,6 +283,13 @@ public:
   bool SkipBytes(int Bytes);
        ///< Skips the given number of bytes in the payload and returns true if there
        ///< is still data left to read.
+  void SkipToStartCode(uint32_t &Scanner);
+       ///< Skips all bytes of the current TS packet that can't complete a start code
+       ///< (0x000001xx) when shifted into Scanner, and updates Scanner as if these bytes
+       ///< had been read by GetByte(). The next call to GetByte() returns the byte
+       ///< immediately following a 0x000001 sequence, or the last byte of the current
+       ///< TS packet (so that the caller can check AtPayloadStart() after reading it).
+       ///< Does nothing if the current position is at the start of a TS packet.
   bool SkipPesHeader(void);
        ///< Skips all bytes belonging to the PES header of the payload.
   int GetLastIndex(void);
@@ -545,6 +565,70 @@ public:
       ///< given to the calls to Check().
   };
 
+class cStreamStatistics {
+private:
+  int pid;
+  int type;
+  bool isVideo;
+  int cc;
+  int packets;
+  int64_t bytes;
+  int ccErrors;
+  int payloadUnits;
+  int64_t firstPts; // first PTS after the last discontinuity
+  int64_t maxPts;
+  int64_t lastPts;
+  int64_t duration; // in PTS ticks, up to the last discontinuity
+  int frameDelta; // smallest PTS delta between two payload units
+  int esBytes; // the number of ES bytes in the current payload unit
+  int lastEsBytes; // the number of ES bytes in the previous payload unit
+  bool esErrors; // the current payload unit has continuity errors
+  bool lastEsErrors; // the previous payload unit has continuity errors
+  double ticksPerByte; // smallest ratio of PTS delta and ES bytes of the previous payload unit
+  int dropouts;
+  int64_t dropoutTicks;
+  int discontinuities;
+public:
+  cStreamStatistics(int Pid, int Type);
+  void Process(const uchar *Data);
+      ///< Processes the single TS packet pointed to by Data, which must belong to
+      ///< this stream and carry an unscrambled payload.
+  int Pid(void) const { return pid; }
+  int Type(void) const { return type; }
+  int Packets(void) const { return packets; }
+  int64_t Bytes(void) const { return bytes; }
+      ///< Returns the number of bytes of all TS packets of this stream.
+  int ContinuityErrors(void) const { return ccErrors; }
+  int PayloadUnits(void) const { return payloadUnits; }
+  double Duration(void) const;
+      ///< Returns the time (in seconds) covered by the PTS values of this stream,
+      ///< not counting any discontinuities.
+  int Bitrate(void) const;
+      ///< Returns the average bitrate (in bit/s) of this stream, or 0 if this
+      ///< information is not (yet) available.
+  double FramesPerSecond(void) const { return frameDelta > 0 ? double(PTSTICKS) / frameDelta : 0; }
+      ///< Returns the number of payload units per second. For streams that carry
+      ///< one frame per payload unit (which is typically the case for audio) this
+      ///< is the frame rate.
+  int Dropouts(void) const { return dropouts; }
+      ///< Returns the number of gaps in the PTS values of this stream, each of which
+      ///< means that at least one frame is missing. Only available for non-video streams,
+      ///< since the PTS values of video streams are not monotonic. Since a payload unit
+      ///< may contain a varying number of (audio) frames, the PTS delta to the next
+      ///< payload unit is compared to the duration of the ES data in the previous one,
+      ///< as given by the smallest ratio of PTS ticks per ES byte seen so far. A gap
+      ///< of less than half the smallest PTS delta is not counted.
+  double DropoutTime(void) const { return double(dropoutTicks) / PTSTICKS; }
+      ///< Returns the total time (in seconds) covered by the dropouts.
+  int Discontinuities(void) const { return discontinuities; }
+      ///< Returns the number of jumps in the PTS values that are too large to be
+      ///< considered a dropout.
+  cString ToString(void) const;
+  cString InfoString(void) const;
+      ///< Returns the statistics of this stream in the form used in the 'Q' lines of a
+      ///< recording's info file (see vdr.5).
+  };
+
 class cFrameDetector {
 private:
   enum { MaxPtsValues = 150 };
@@ -572,6 +656,8 @@ private:
   cFrameParser *parser;
   cTsChecker *tsChecker;
   cPtsChecker *ptsChecker;
+  cVector<cStreamStatistics *> streams;
+  void ProcessStreams(const uchar *Data, int Length);
 public:
   cFrameDetector(int Pid = 0, int Type = 0);
       ///< Sets up a frame detector for the given Pid and stream Type.
@@ -580,6 +666,15 @@ public:
   ~cFrameDetector();
   void SetPid(int Pid, int Type);
       ///< Sets the Pid and stream Type to detect frames for.
+  void AddStream(int Pid, int Type);
+      ///< Adds the given Pid and stream Type to the elementary streams for which
+      ///< statistics are collected in Analyze(), in addition to the one frames are
+      ///< detected for. The Pid frames are detected for is ignored here.
+      ///< If no streams are added, no statistics are collected at all.
+  int NumStreams(void) const { return streams.Size(); }
+  const cStreamStatistics *Stream(int Index) const { return streams[Index]; }
+      ///< Returns the statistics of the stream with the given Index (which must be
+      ///< in the range 0..NumStreams() - 1), in the order the streams were added.
   [[deprecated("use SetLastPts() instead")]] void SetMissing(void) {}
   void SetLastPts(int64_t LastPts);
       ///< If this is a resumed recording, call this function with the last PTS of
@@ -11,8 +11,13 @@
  */
 
 #include "ringbuffer.h"
+#include <linux/mempolicy.h>
+#include <sched.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <unistd.h>
+#include "config.h"
 #include "tools.h"
 
 // --- cRingBuffer -----------------------------------------------------------
@@ -32,6 +37,7 @@ cRingBuffer::cRingBuffer(int Size, bool Statistics)
   lastPercent = 0;
   putTimeout = getTimeout = 0;
   lastOverflowReport = 0;
+  putWaiting = getWaiting = false;
   overflowCount = overflowBytes = 0;
   ioThrottle = NULL;
 }
@@ -62,28 +68,50 @@ void cRingBuffer::UpdatePercentage(int Fill)
      }
 }
 
+// The waiting thread first announces that it is waiting and then checks the buffer
+// once more, while the other thread first modifies the buffer and then checks whether
+// anybody is waiting. The fences make sure that at least one of them sees what the
+// other one did, so the (comparatively expensive) Signal() is only called if there
+// actually is a thread waiting, and no wakeup can get lost.
+
 void cRingBuffer::WaitForPut(void)
 {
-  if (putTimeout)
-     readyForPut.Wait(putTimeout);
+  if (putTimeout) {
+     putWaiting.store(true, std::memory_order_relaxed);
+     std::atomic_thread_fence(std::memory_order_seq_cst);
+     if (Free() <= Size() / 10)
+        readyForPut.Wait(putTimeout);
+     putWaiting.store(false, std::memory_order_relaxed);
+     }
 }
 
 void cRingBuffer::WaitForGet(void)
 {
-  if (getTimeout)
-     readyForGet.Wait(getTimeout);
+  if (getTimeout) {
+     getWaiting.store(true, std::memory_order_relaxed);
+     std::atomic_thread_fence(std::memory_order_seq_cst);
+     if (Available() <= Size() / 10)
+        readyForGet.Wait(getTimeout);
+     getWaiting.store(false, std::memory_order_relaxed);
+     }
 }
 
 void cRingBuffer::EnablePut(void)
 {
-  if (putTimeout && Free() > Size() / 10)
-     readyForPut.Signal();
+  if (putTimeout && Free() > Size() / 10) {
+     std::atomic_thread_fence(std::memory_order_seq_cst);
+     if (putWaiting.load(std::memory_order_relaxed))
+        readyForPut.Signal();
+     }
 }
 
 void cRingBuffer::EnableGet(void)
 {
-  if (getTimeout && Available() > Size() / 10)
-     readyForGet.Signal();
+  if (getTimeout && Available() > Size() / 10) {
+     std::atomic_thread_fence(std::memory_order_seq_cst);
+     if (getWaiting.load(std::memory_order_relaxed))
+        readyForGet.Signal();
+     }
 }
 
 void cRingBuffer::SetTimeouts(int PutTimeout, int GetTimeout)
@@ -171,12 +199,16 @@ cRingBufferLinear::cRingBufferLinear(int Size, int Margin, bool Statistics, cons
 :cRingBuffer(Size, Statistics)
 {
   description = Description ? strdup(Description) : NULL;
-  tail = head = margin = Margin;
+  margin = Margin;
+  head.store(margin);
+  tail.store(margin);
   gotten = 0;
   buffer = NULL;
+  mapped = 0;
+  numaLocal = false;
   if (Size > 1) { // 'Size - 1' must not be 0!
      if (Margin <= Size / 2) {
-        buffer = MALLOC(uchar, Size);
+        buffer = AllocateBuffer(Size);
         if (!buffer)
            esyslog("ERROR: can't allocate ring buffer (size=%d)", Size);
         Clear();
@@ -199,10 +231,66 @@ cRingBufferLinear::~cRingBufferLinear()
 #ifdef DEBUGRINGBUFFERS
   DelDebugRBL(this);
 #endif
-  free(buffer);
+  if (mapped)
+     munmap(buffer, mapped);
+  else
+     free(buffer);
   free(description);
 }
 
+#define HUGEPAGESIZE    MEGABYTE(2)
+#define MINMAPPEDBUFFER MEGABYTE(1) // smaller buffers are always allocated with malloc()
+
+uchar *cRingBufferLinear::AllocateBuffer(int Size)
+{
+  if (Size >= MINMAPPEDBUFFER && (Setup.BufferHugePages || Setup.BufferNumaLocal)) {
+     size_t Length = (Size + HUGEPAGESIZE - 1) / HUGEPAGESIZE * HUGEPAGESIZE;
+     void *p = MAP_FAILED;
+     if (Setup.BufferHugePages == 2) {
+        p = mmap(NULL, Length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED)
+           dsyslog("no huge pages available for %s buffer (%d bytes), using transparent huge pages", description ? description : "ring", Size);
+        }
+     if (p == MAP_FAILED) {
+        // Map one extra huge page, so that the buffer can start at a huge page boundary:
+        p = mmap(NULL, Length + HUGEPAGESIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED) {
+           uchar *a = (uchar *)(((uintptr_t)p + HUGEPAGESIZE - 1) & ~uintptr_t(HUGEPAGESIZE - 1));
+           if (a > p)
+              munmap(p, a - (uchar *)p);
+           munmap(a + Length, (uchar *)p + HUGEPAGESIZE - a);
+           p = a;
+           if (Setup.BufferHugePages && madvise(p, Length, MADV_HUGEPAGE) < 0)
+              LOG_ERROR;
+           }
+        }
+     if (p != MAP_FAILED) {
+        mapped = Length;
+        numaLocal = Setup.BufferNumaLocal;
+        return (uchar *)p;
+        }
+     LOG_ERROR;
+     }
+  return MALLOC(uchar, Size);
+}
+
+void cRingBufferLinear::MoveToLocalNode(void)
+{
+  unsigned int Cpu, Node;
+  if (getcpu(&Cpu, &Node) == 0) {
+     unsigned long NodeMask[1024 / (8 * sizeof(unsigned long))] = { 0 };
+     if (Node < sizeof(NodeMask) * 8) {
+        NodeMask[Node / (8 * sizeof(unsigned long))] |= 1UL << (Node % (8 * sizeof(unsigned long)));
+        if (syscall(SYS_mbind, buffer, mapped, MPOL_PREFERRED, NodeMask, sizeof(NodeMask) * 8, MPOL_MF_MOVE) == 0)
+           dsyslog("%s buffer bound to NUMA node %d", description ? description : "ring", Node);
+        else
+           LOG_ERROR;
+        }
+     }
+  else
+     LOG_ERROR;
+}
+
 int cRingBufferLinear::DataReady(const uchar *Data, int Count)
 {
   return Count >= margin ? Count : 0;
@@ -210,17 +298,17 @@ int cRingBufferLinear::DataReady(const uchar *Data, int Count)
 
 int cRingBufferLinear::Available(void)
 {
-  int diff = head - tail;
+  int diff = head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
   return (diff >= 0) ? diff : Size() + diff - margin;
 }
 
 void cRingBufferLinear::Clear(void)
 {
-  int Head = head;
-  tail = Head;
+  int Head = head.load(std::memory_order_acquire);
+  tail.store(Head, std::memory_order_release);
 #ifdef DEBUGRINGBUFFERS
   lastHead = Head;
-  lastTail = tail;
+  lastTail = Head;
   lastPut = lastGet = -1;
 #endif
   maxFill = 0;
@@ -229,9 +317,10 @@ void cRingBufferLinear::Clear(void)
 
 int cRingBufferLinear::Read(int FileHandle, int Max)
 {
-  int Tail = tail;
-  int diff = Tail - head;
-  int free = (diff > 0) ? diff - 1 : Size() - head;
+  int Head = head.load(std::memory_order_relaxed);
+  int Tail = tail.load(std::memory_order_acquire);
+  int diff = Tail - Head;
+  int free = (diff > 0) ? diff - 1 : Size() - Head;
   if (Tail <= margin)
      free--;
   int Count = -1;
@@ -239,14 +328,14 @@ int cRingBufferLinear::Read(int FileHandle, int Max)
   if (free > 0) {
      if (0 < Max && Max < free)
         free = Max;
-     Count = safe_read(FileHandle, buffer + head, free);
+     Count = safe_read(FileHandle, buffer + Head, free);
      if (Count > 0) {
-        int Head = head + Count;
+        Head += Count;
         if (Head >= Size())
            Head = margin;
-        head = Head;
+        head.store(Head, std::memory_order_release);
         if (statistics) {
-           int fill = head - Tail;
+           int fill = Head - Tail;
            if (fill < 0)
               fill = Size() + fill;
            else if (fill >= Size())
@@ -256,7 +345,7 @@ int cRingBufferLinear::Read(int FileHandle, int Max)
         }
      }
 #ifdef DEBUGRINGBUFFERS
-  lastHead = head;
+  lastHead = Head;
   lastPut = Count;
 #endif
   EnableGet();
@@ -267,9 +356,10 @@ int cRingBufferLinear::Read(int FileHandle, int Max)
 
 int cRingBufferLinear::Read(cUnbufferedFile *File, int Max)
 {
-  int Tail = tail;
-  int diff = Tail - head;
-  int free = (diff > 0) ? diff - 1 : Size() - head;
+  int Head = head.load(std::memory_order_relaxed);
+  int Tail = tail.load(std::memory_order_acquire);
+  int diff = Tail - Head;
+  int free = (diff > 0) ? diff - 1 : Size() - Head;
   if (Tail <= margin)
      free--;
   int Count = -1;
@@ -277,14 +367,14 @@ int cRingBufferLinear::Read(cUnbufferedFile *File, int Max)
   if (free > 0) {
      if (0 < Max && Max < free)
         free = Max;
-     Count = File->Read(buffer + head, free);
+     Count = File->Read(buffer + Head, free);
      if (Count > 0) {
-        int Head = head + Count;
+        Head += Count;
         if (Head >= Size())
            Head = margin;
-        head = Head;
+        head.store(Head, std::memory_order_release);
         if (statistics) {
-           int fill = head - Tail;
+           int fill = Head - Tail;
            if (fill < 0)
               fill = Size() + fill;
            else if (fill >= Size())
@@ -294,7 +384,7 @@ int cRingBufferLinear::Read(cUnbufferedFile *File, int Max)
         }
      }
 #ifdef DEBUGRINGBUFFERS
-  lastHead = head;
+  lastHead = Head;
   lastPut = Count;
 #endif
   EnableGet();
@@ -306,9 +396,10 @@ int cRingBufferLinear::Read(cUnbufferedFile *File, int Max)
 int cRingBufferLinear::Put(const uchar *Data, int Count)
 {
   if (Count > 0) {
-     int Tail = tail;
-     int rest = Size() - head;
-     int diff = Tail - head;
+     int Head = head.load(std::memory_order_relaxed);
+     int Tail = tail.load(std::memory_order_acquire);
+     int rest = Size() - Head;
+     int diff = Tail - Head;
      int free = ((Tail < margin) ? rest : (diff > 0) ? diff : Size() + diff - margin) - 1;
      if (statistics) {
         int fill = Size() - free - 1 + Count;
@@ -320,20 +411,21 @@ int cRingBufferLinear::Put(const uchar *Data, int Count)
         if (free < Count)
            Count = free;
         if (Count >= rest) {
-           memcpy(buffer + head, Data, rest);
+           memcpy(buffer + Head, Data, rest);
            if (Count - rest)
               memcpy(buffer + margin, Data + rest, Count - rest);
-           head = margin + Count - rest;
+           Head = margin + Count - rest;
            }
         else {
-           memcpy(buffer + head, Data, Count);
-           head += Count;
+           memcpy(buffer + Head, Data, Count);
+           Head += Count;
            }
+        head.store(Head, std::memory_order_release);
         }
      else
         Count = 0;
 #ifdef DEBUGRINGBUFFERS
-     lastHead = head;
+     lastHead = Head;
      lastPut = Count;
 #endif
      EnableGet();
@@ -345,21 +437,26 @@ int cRingBufferLinear::Put(const uchar *Data, int Count)
 
 uchar *cRingBufferLinear::Get(int &Count)
 {
-  int Head = head;
-  if (getThreadTid <= 0)
+  int Head = head.load(std::memory_order_acquire);
+  int Tail = tail.load(std::memory_order_relaxed);
+  if (getThreadTid <= 0) {
      getThreadTid = cThread::ThreadId();
-  int rest = Size() - tail;
-  if (rest < margin && Head < tail) {
+     if (numaLocal)
+        MoveToLocalNode();
+     }
+  int rest = Size() - Tail;
+  if (rest < margin && Head < Tail) {
      int t = margin - rest;
-     memcpy(buffer + t, buffer + tail, rest);
-     tail = t;
-     rest = Head - tail;
+     memcpy(buffer + t, buffer + Tail, rest);
+     Tail = t;
+     tail.store(Tail, std::memory_order_release);
+     rest = Head - Tail;
      }
-  int diff = Head - tail;
+  int diff = Head - Tail;
   int cont = (diff >= 0) ? diff : Size() + diff - margin;
   if (cont > rest)
      cont = rest;
-  uchar *p = buffer + tail;
+  uchar *p = buffer + Tail;
   if ((cont = DataReady(p, cont)) > 0) {
      Count = gotten = cont;
      return p;
@@ -375,12 +472,12 @@ void cRingBufferLinear::Del(int Count)
      Count = gotten;
      }
   if (Count > 0) {
-     int Tail = tail;
+     int Tail = tail.load(std::memory_order_relaxed);
      Tail += Count;
      gotten -= Count;
      if (Tail >= Size())
         Tail = margin;
-     tail = Tail;
+     tail.store(Tail, std::memory_order_release);
      EnablePut();
      }
 #ifdef DEBUGRINGBUFFERS
@@ -389,19 +486,114 @@ void cRingBufferLinear::Del(int Count)
 #endif
 }
 
+// --- cFramePool ------------------------------------------------------------
+
+#define FRAMEPOOLMINSHIFT 6 // the smallest block is 64 bytes
+#define FRAMEPOOLMINBLOCK (1 << FRAMEPOOLMINSHIFT)
+#define FRAMEPOOLCLASSES  (1 + 4 * 14) // 64 bytes and four classes per power of two up to 1MB (2^20)
+
+struct alignas(16) tFramePoolBlock {
+  tFramePoolBlock *next; // only valid while the block is unused
+  int sizeClass; // -1 if this block is not kept for reuse
+  int size;
+  };
+
+static cMutex FramePoolMutex;
+static tFramePoolBlock *FramePoolFree[FRAMEPOOLCLASSES] = { NULL };
+static int FramePoolUsedBytes = 0;
+static int FramePoolFreeBytes = 0;
+static int FramePoolAllocs = 0;
+static int FramePoolReuses = 0;
+
+static int FramePoolSizeClass(int Size, int &BlockSize)
+{
+  if (Size <= FRAMEPOOLMINBLOCK) {
+     BlockSize = FRAMEPOOLMINBLOCK;
+     return 0;
+     }
+  if (Size > FRAMEPOOLMAXBLOCK) {
+     BlockSize = Size;
+     return -1;
+     }
+  int Shift = FRAMEPOOLMINSHIFT;
+  while ((2 << Shift) < Size)
+        Shift++;
+  // Now 2^Shift < Size <= 2^(Shift + 1), which is divided into four classes:
+  int Step = 1 << (Shift - 2);
+  int q = (Size - (1 << Shift) + Step - 1) / Step;
+  BlockSize = (1 << Shift) + q * Step;
+  return 4 * (Shift - FRAMEPOOLMINSHIFT) + q;
+}
+
+void *cFramePool::Alloc(int Size)
+{
+  int BlockSize;
+  int SizeClass = FramePoolSizeClass(Size, BlockSize);
+  tFramePoolBlock *Block = NULL;
+  {
+    cMutexLock MutexLock(&FramePoolMutex);
+    if (SizeClass >= 0 && (Block = FramePoolFree[SizeClass]) != NULL) {
+       FramePoolFree[SizeClass] = Block->next;
+       FramePoolFreeBytes -= BlockSize;
+       FramePoolReuses++;
+       }
+    FramePoolUsedBytes += BlockSize;
+    FramePoolAllocs++;
+  }
+  if (!Block) {
+     Block = (tFramePoolBlock *)malloc(sizeof(tFramePoolBlock) + BlockSize);
+     if (!Block) {
+        esyslog("ERROR: can't allocate frame pool block (size=%d)", BlockSize);
+        cMutexLock MutexLock(&FramePoolMutex);
+        FramePoolUsedBytes -= BlockSize;
+        return NULL;
+        }
+     Block->sizeClass = SizeClass;
+     Block->size = BlockSize;
+     }
+  return Block + 1;
+}
+
+void cFramePool::Free(void *Data)
+{
+  if (Data) {
+     tFramePoolBlock *Block = (tFramePoolBlock *)Data - 1;
+     {
+       cMutexLock MutexLock(&FramePoolMutex);
+       FramePoolUsedBytes -= Block->size;
+       if (Block->sizeClass >= 0 && FramePoolFreeBytes + Block->size <= FRAMEPOOLMAXFREE) {
+          Block->next = FramePoolFree[Block->sizeClass];
+          FramePoolFree[Block->sizeClass] = Block;
+          FramePoolFreeBytes += Block->size;
+          return;
+          }
+     }
+     free(Block);
+     }
+}
+
+cString cFramePool::Metrics(void)
+{
+  cMutexLock MutexLock(&FramePoolMutex);
+  return cString::sprintf("used=%d free=%d allocs=%d reuses=%d", FramePoolUsedBytes, FramePoolFreeBytes, FramePoolAllocs, FramePoolReuses);
+}
+
 // --- cFrame ----------------------------------------------------------------
 
-cFrame::cFrame(const uchar *Data, int Count, eFrameType Type, int Index, uint32_t Pts, bool Independent)
+cFrame::cFrame(const uchar *Data, int Count, eFrameType Type, int Index, uint32_t Pts, bool Independent, bool Pooled)
 {
   count = abs(Count);
   type = Type;
   index = Index;
   pts = Pts;
   independent = Type == ftAudio ? true : Independent;
-  if (Count < 0)
+  if (Count < 0) {
      data = (uchar *)Data;
+     pooled = Pooled;
+     }
   else {
-     data = MALLOC(uchar, count);
+     data = (uchar *)cFramePool::Alloc(count);
+     pooled = true;
      if (data)
         memcpy(data, Data, count);
      else
@@ -412,7 +604,10 @@ cFrame::cFrame(const uchar *Data, int Count, eFrameType Type, int Index, uint32_
 
 cFrame::~cFrame()
 {
-  free(data);
+  if (pooled)
+     cFramePool::Free(data);
+  else
+     free(data);
 }
 
 // --- cRingBufferFrame ------------------------------------------------------
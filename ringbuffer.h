@@ -10,12 +10,17 @@
 #ifndef __RINGBUFFER_H
 #define __RINGBUFFER_H
 
+#include <atomic>
 #include "thread.h"
 #include "tools.h"
 
+#define CACHELINESIZE 64 // used to keep data written by different threads apart
+
 class cRingBuffer {
 private:
   cCondWait readyForPut, readyForGet;
+  std::atomic<bool> putWaiting; // the writing thread is waiting in WaitForPut()
+  std::atomic<bool> getWaiting; // the reading thread is waiting in WaitForGet()
   int putTimeout;
   int getTimeout;
   int size;
@@ -43,8 +48,19 @@ public:
   void SetTimeouts(int PutTimeout, int GetTimeout);
   void SetIoThrottle(void);
   void ReportOverflow(int Bytes);
+  int MaxFill(void) { return maxFill * 100 / (size - 1); }
+      ///< Returns the maximum fill level (in percent) this buffer has reached so far.
+      ///< This is only available if the buffer has been created with Statistics
+      ///< set to true, otherwise 0 is returned.
   };
 
+/// cRingBufferLinear is meant to be used by exactly one thread that writes data into
+/// it (by calling Read() or Put()) and one thread that reads data from it (by calling
+/// Get() and Del()). The writing thread only modifies 'head' and the reading thread only
+/// modifies 'tail', so no locking is necessary. Data is published with release/acquire
+/// semantics, and the two are kept in separate cache lines. A thread that waits for data
+/// or free space is only signaled if it actually waits.
+
 class cRingBufferLinear : public cRingBuffer {
 //#define DEBUGRINGBUFFERS
 #ifdef DEBUGRINGBUFFERS
@@ -58,10 +74,20 @@ public:
   static void PrintDebugRBL(void);
 #endif
 private:
-  int margin, head, tail;
-  int gotten;
+  int margin;
   uchar *buffer;
+  size_t mapped; // the size of the memory mapping holding the buffer, 0 if it was allocated with malloc()
+  bool numaLocal;
   char *description;
+  alignas(CACHELINESIZE) std::atomic<int> head; // only written by the writing thread
+  alignas(CACHELINESIZE) std::atomic<int> tail; // only written by the reading thread
+  int gotten;
+  uchar *AllocateBuffer(int Size);
+      ///< Allocates the memory for the buffer, according to the settings in
+      ///< Setup.BufferHugePages and Setup.BufferNumaLocal.
+  void MoveToLocalNode(void);
+      ///< Binds the buffer's memory to the NUMA node of the calling thread and
+      ///< moves any pages that have already been allocated there.
 protected:
   virtual int DataReady(const uchar *Data, int Count);
     ///< By default a ring buffer has data ready as soon as there are at least
@@ -104,6 +130,30 @@ public:
     ///< call to Get().
   };
 
+/// cFramePool provides the memory for cFrame objects and their data, so that
+/// replaying doesn't need to call malloc() and free() for every single frame.
+/// Blocks are grouped into size classes (four per power of two, from 64 bytes
+/// up to FRAMEPOOLMAXBLOCK). Blocks that are no longer used are kept for reuse,
+/// up to a total of FRAMEPOOLMAXFREE bytes. Larger blocks are allocated with
+/// malloc() and freed immediately.
+
+#define FRAMEPOOLMAXBLOCK MEGABYTE(1) // the largest block that is kept for reuse (at least MAXFRAMESIZE)
+#define FRAMEPOOLMAXFREE  MEGABYTE(8) // the maximum number of bytes kept in unused blocks
+
+class cFramePool {
+public:
+  static void *Alloc(int Size);
+    ///< Returns a pointer to a block of at least Size bytes, or NULL if no memory
+    ///< is available.
+  static void Free(void *Data);
+    ///< Returns the given block, which must have been allocated by Alloc(), to the
+    ///< pool. Data may be NULL.
+  static cString Metrics(void);
+    ///< Returns the number of bytes in used and unused blocks, as well as the number
+    ///< of allocations and how many of them reused a block, in the form
+    ///< "key=value key=value...".
+  };
+
 enum eFrameType { ftUnknown, ftVideo, ftAudio, ftDolby };
 
 class cFrame {
@@ -116,12 +166,17 @@ private:
   int index;
   uint32_t pts;
   bool independent;
+  bool pooled;
 public:
-  cFrame(const uchar *Data, int Count, eFrameType = ftUnknown, int Index = -1, uint32_t Pts = 0, bool independent = false);
+  cFrame(const uchar *Data, int Count, eFrameType = ftUnknown, int Index = -1, uint32_t Pts = 0, bool independent = false, bool Pooled = false);
     ///< Creates a new cFrame object.
     ///< If Count is negative, the cFrame object will take ownership of the given
-    ///< Data. Otherwise it will allocate Count bytes of memory and copy Data.
+    ///< Data, which must have been allocated with malloc() or, if Pooled is true,
+    ///< with cFramePool::Alloc(). Otherwise it will allocate Count bytes of memory
+    ///< from cFramePool and copy Data.
   ~cFrame();
+  void *operator new(size_t Size) noexcept { return cFramePool::Alloc(Size); }
+  void operator delete(void *p) { cFramePool::Free(p); }
   uchar *Data(void) const { return data; }
   int Count(void) const { return count; }
   eFrameType Type(void) const { return type; }
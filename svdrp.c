@@ -33,6 +33,7 @@
 #include "eitscan.h"
 #include "keys.h"
 #include "menu.h"
+#include "metrics.h"
 #include "plugin.h"
 #include "recording.h"
 #include "remote.h"
@@ -1011,7 +1012,14 @@ const char *HelpPages[] = {
   "    Forces an EPG scan. If this is a single DVB device system, the scan\n"
   "    will be done on the primary device unless it is currently recording.",
   "STAT disk\n"
-  "    Return information about disk usage (total, free, percent).",
+  "    Return information about disk usage (total, free, percent).\n"
+  "STAT metrics\n"
+  "    Return runtime metrics of VDR, the video disk, all devices and their\n"
+  "    receivers (including recordings). Each line describes one object and\n"
+  "    consists of the kind of object (vdr, disk, framepool, readcache, epg,\n"
+  "    device or receiver), the object's number (if applicable) and any\n"
+  "    number of key=value pairs. Values that may contain blanks are enclosed\n"
+  "    in double quotes, with any '\"' and '\\' escaped by a backslash.",
   "UPDT <settings>\n"
   "    Updates a timer. Settings must be in the same format as returned\n"
   "    by the LSTT command. If a timer with the same channel, day, start\n"
@@ -2567,6 +2575,12 @@ void cSVDRPServer::CmdSTAT(const char *Option)
         int Percent = cVideoDirectory::VideoDiskSpace(&FreeMB, &UsedMB);
         Reply(250, "%dMB %dMB %d%%", FreeMB + UsedMB, FreeMB, Percent);
         }
+     else if (strcasecmp(Option, "METRICS") == 0) {
+        cStringList Lines;
+        cMetrics::GetMetrics(Lines);
+        for (int i = 0; i < Lines.Size(); i++)
+            Reply(i < Lines.Size() - 1 ? -250 : 250, "%s", Lines[i]);
+        }
      else
         Reply(501, "Invalid Option \"%s\"", Option);
      }
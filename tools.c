@@ -11,6 +11,7 @@
 #include <ctype.h>
 #include <dirent.h>
 #include <errno.h>
+#include <inttypes.h>
 extern "C" {
 #ifdef boolean
 #define HAVE_BOOLEAN
@@ -1821,9 +1822,254 @@ bool cSafeFile::Close(void)
 
 #define WRITE_BUFFER KILOBYTE(800)
 
+// --- cUnbufferedFileWriter -------------------------------------------------
+
+#define ASYNCWRITEWAIT 100 // ms the writer waits for new data
+
+class cUnbufferedFileWriter : public cThread {
+private:
+  cUnbufferedFile *file;
+  cMutex mutex;
+  cCondVar dataAvailable;
+  cCondVar dataWritten;
+  uchar *buffer[2];
+  int size;     // the size of each of the buffers
+  int current;  // the buffer Put() appends to
+  int fill;     // the number of bytes in the current buffer
+  int writing;  // the number of bytes in the other buffer that are being written
+  off_t written;
+  int error;
+protected:
+  virtual void Action(void) override;
+public:
+  cUnbufferedFileWriter(cUnbufferedFile *File, int Size);
+  virtual ~cUnbufferedFileWriter() override;
+  ssize_t Put(const void *Data, size_t Size);
+  bool Flush(void);
+  off_t Written(void) { cMutexLock MutexLock(&mutex); return written; }
+  };
+
+cUnbufferedFileWriter::cUnbufferedFileWriter(cUnbufferedFile *File, int Size)
+:cThread("file writer")
+{
+  file = File;
+  size = Size;
+  buffer[0] = MALLOC(uchar, size);
+  buffer[1] = MALLOC(uchar, size);
+  current = 0;
+  fill = 0;
+  writing = 0;
+  written = file->curpos;
+  error = (buffer[0] && buffer[1]) ? 0 : ENOMEM;
+  Start();
+}
+
+cUnbufferedFileWriter::~cUnbufferedFileWriter()
+{
+  Flush();
+  Cancel(-1);
+  dataAvailable.Broadcast();
+  Cancel(3);
+  free(buffer[0]);
+  free(buffer[1]);
+}
+
+void cUnbufferedFileWriter::Action(void)
+{
+  cMutexLock MutexLock(&mutex);
+  while (Running()) {
+        if (fill > 0 && !error) {
+           // Swap buffers, so that Put() can continue while we write:
+           uchar *b = buffer[current];
+           writing = fill;
+           current = 1 - current;
+           fill = 0;
+           mutex.Unlock();
+           ssize_t w = file->WriteData(b, writing);
+           mutex.Lock();
+           if (w != writing)
+              error = w < 0 ? errno : EIO;
+           else
+              written += w;
+           writing = 0;
+           dataWritten.Broadcast();
+           }
+        else
+           dataAvailable.TimedWait(mutex, ASYNCWRITEWAIT);
+        }
+}
+
+ssize_t cUnbufferedFileWriter::Put(const void *Data, size_t Size)
+{
+  cMutexLock MutexLock(&mutex);
+  const uchar *p = (const uchar *)Data;
+  size_t Rest = Size;
+  while (Rest > 0 && !error) {
+        int n = min(Rest, size_t(size - fill));
+        if (n > 0) {
+           memcpy(buffer[current] + fill, p, n);
+           fill += n;
+           p += n;
+           Rest -= n;
+           dataAvailable.Broadcast();
+           }
+        else
+           dataWritten.Wait(mutex);
+        }
+  if (error) {
+     errno = error;
+     return -1;
+     }
+  return Size;
+}
+
+bool cUnbufferedFileWriter::Flush(void)
+{
+  cMutexLock MutexLock(&mutex);
+  while ((fill > 0 || writing > 0) && !error && Active())
+        dataWritten.Wait(mutex);
+  if (error) {
+     errno = error;
+     return false;
+     }
+  return true;
+}
+
+// --- cUnbufferedFileCoordinator --------------------------------------------
+
+// Several cUnbufferedFile objects may read the same file at the same time, e.g.
+// if a recording is replayed and streamed to clients. Data that one of them has
+// just read is likely to be read by the others soon, so it must not be dropped
+// from the file system cache, and there's no need to request read-ahead for it.
+
+#define SHAREDKEEPAHEAD  MEGABYTE(64) // data ahead of a reader's position that is kept in the cache for it
+#define SHAREDKEEPBEHIND MEGABYTE(8)  // data behind a reader's position that is kept in the cache for it
+
+class cUnbufferedFileCoordinator {
+private:
+  cMutex mutex;
+  cVector<cUnbufferedFile *> files;
+  int64_t readBytes;
+  int64_t sharedBytes;
+  int64_t keptBytes;
+  void Drop(cUnbufferedFile *File, off_t Begin, off_t End, int From);
+public:
+  cUnbufferedFileCoordinator(void);
+  void Add(cUnbufferedFile *File);
+  void Del(cUnbufferedFile *File);
+  void Read(cUnbufferedFile *File, off_t Offset, ssize_t Bytes);
+  bool Shared(cUnbufferedFile *File, off_t Offset, off_t Len);
+  void Drop(cUnbufferedFile *File, off_t Offset, off_t Len);
+  cString Metrics(void);
+  };
+
+static cUnbufferedFileCoordinator UnbufferedFileCoordinator;
+
+cUnbufferedFileCoordinator::cUnbufferedFileCoordinator(void)
+{
+  readBytes = 0;
+  sharedBytes = 0;
+  keptBytes = 0;
+}
+
+void cUnbufferedFileCoordinator::Add(cUnbufferedFile *File)
+{
+  struct stat st;
+  if (fstat(File->fd, &st) == 0 && S_ISREG(st.st_mode)) {
+     cMutexLock MutexLock(&mutex);
+     File->dev = st.st_dev;
+     File->ino = st.st_ino;
+     File->readpos = -1;
+     files.Append(File);
+     }
+}
+
+void cUnbufferedFileCoordinator::Del(cUnbufferedFile *File)
+{
+  cMutexLock MutexLock(&mutex);
+  int i = files.IndexOf(File);
+  if (i >= 0)
+     files.Remove(i);
+}
+
+void cUnbufferedFileCoordinator::Read(cUnbufferedFile *File, off_t Offset, ssize_t Bytes)
+{
+  cMutexLock MutexLock(&mutex);
+  File->readpos = Offset + Bytes;
+  readBytes += Bytes;
+  // The data counts as shared if another reader has read it shortly before:
+  for (int i = 0; i < files.Size(); i++) {
+      cUnbufferedFile *f = files[i];
+      if (f != File && f->ino == File->ino && f->dev == File->dev && f->readpos >= Offset + Bytes && f->readpos - Offset <= SHAREDKEEPAHEAD) {
+         sharedBytes += Bytes;
+         break;
+         }
+      }
+}
+
+bool cUnbufferedFileCoordinator::Shared(cUnbufferedFile *File, off_t Offset, off_t Len)
+{
+  cMutexLock MutexLock(&mutex);
+  for (int i = 0; i < files.Size(); i++) {
+      cUnbufferedFile *f = files[i];
+      if (f != File && f->ino == File->ino && f->dev == File->dev && f->readpos >= Offset + Len && f->readpos - Offset <= SHAREDKEEPAHEAD)
+         return true;
+      }
+  return false;
+}
+
+void cUnbufferedFileCoordinator::Drop(cUnbufferedFile *File, off_t Begin, off_t End, int From)
+{
+  // Drops the data from Begin to End (0 = end of file), except for the areas
+  // other readers of the same file are about to read. Only the readers at
+  // indexes from From on are checked, since the ones before that have already
+  // been excluded by the caller.
+  if (End && End <= Begin)
+     return;
+  for (int i = From; i < files.Size(); i++) {
+      cUnbufferedFile *f = files[i];
+      if (f != File && f->ino == File->ino && f->dev == File->dev && f->readpos >= 0) {
+         off_t KeepBegin = max(f->readpos - off_t(SHAREDKEEPBEHIND), off_t(0));
+         off_t KeepEnd = f->readpos + SHAREDKEEPAHEAD;
+         if (KeepEnd > Begin && (End == 0 || KeepBegin < End)) {
+            keptBytes += (End ? min(End, KeepEnd) : KeepEnd) - max(Begin, KeepBegin);
+            if (KeepBegin > Begin)
+               Drop(File, Begin, KeepBegin, i + 1);
+            if (End == 0 || KeepEnd < End)
+               Drop(File, KeepEnd, End, i + 1);
+            return;
+            }
+         }
+      }
+  posix_fadvise(File->fd, Begin, End ? End - Begin : 0, POSIX_FADV_DONTNEED);
+}
+
+void cUnbufferedFileCoordinator::Drop(cUnbufferedFile *File, off_t Offset, off_t Len)
+{
+  cMutexLock MutexLock(&mutex);
+  Drop(File, max(Offset, off_t(0)), Len ? Offset + Len : 0, 0);
+}
+
+cString cUnbufferedFileCoordinator::Metrics(void)
+{
+  cMutexLock MutexLock(&mutex);
+  int Readers = 0;
+  for (int i = 0; i < files.Size(); i++) {
+      if (files[i]->readpos >= 0)
+         Readers++;
+      }
+  return cString::sprintf("files=%d readers=%d read=%" PRId64 " shared=%" PRId64 " hits=%d%% kept=%" PRId64, files.Size(), Readers, readBytes, sharedBytes, readBytes ? int(sharedBytes * 100 / readBytes) : 0, keptBytes);
+}
+
+// --- cUnbufferedFile -------------------------------------------------------
+
 cUnbufferedFile::cUnbufferedFile(void)
 {
   fd = -1;
+  dev = 0;
+  ino = 0;
+  readpos = -1;
+  writer = NULL;
 }
 
 cUnbufferedFile::~cUnbufferedFile()
@@ -1836,10 +2082,14 @@ int cUnbufferedFile::Open(const char *FileName, int Flags, mode_t Mode)
   Close();
   fd = open(FileName, Flags, Mode);
   curpos = 0;
+  if (fd >= 0)
+     UnbufferedFileCoordinator.Add(this);
 #if USE_FADVISE_READ || USE_FADVISE_WRITE
   begin = lastpos = ahead = 0;
   cachedstart = 0;
   cachedend = 0;
+  prefetchstart = 0;
+  prefetchend = 0;
   readahead = KILOBYTE(128);
   written = 0;
   totwritten = 0;
@@ -1851,15 +2101,29 @@ int cUnbufferedFile::Open(const char *FileName, int Flags, mode_t Mode)
 
 int cUnbufferedFile::Close(void)
 {
+  int Error = 0;
+  if (writer) {
+     if (!writer->Flush())
+        Error = errno;
+     delete writer;
+     writer = NULL;
+     }
   if (fd >= 0) {
 #if USE_FADVISE_READ || USE_FADVISE_WRITE
      if (totwritten)    // if we wrote anything make sure the data has hit the disk before
         fdatasync(fd);  // calling fadvise, as this is our last chance to un-cache it.
-     posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+     UnbufferedFileCoordinator.Drop(this, 0, 0);
 #endif
+     UnbufferedFileCoordinator.Del(this);
      int OldFd = fd;
      fd = -1;
-     return close(OldFd);
+     if (close(OldFd) < 0)
+        return -1;
+     if (Error) {
+        errno = Error;
+        return -1;
+        }
+     return 0;
      }
   errno = EBADF;
   return -1;
@@ -1878,10 +2142,17 @@ void cUnbufferedFile::SetReadAhead(size_t ra)
   readahead = ra;
 }
 
+void cUnbufferedFile::SetAsyncWrite(int BufferSize)
+{
+  if (fd >= 0 && !writer && BufferSize > 0)
+     writer = new cUnbufferedFileWriter(this, BufferSize);
+}
+
 int cUnbufferedFile::FadviseDrop(off_t Offset, off_t Len)
 {
   // rounding up the window to make sure that not PAGE_SIZE-aligned data gets freed.
-  return posix_fadvise(fd, Offset - (FADVGRAN - 1), Len + (FADVGRAN - 1) * 2, POSIX_FADV_DONTNEED);
+  UnbufferedFileCoordinator.Drop(this, Offset - (FADVGRAN - 1), Len + (FADVGRAN - 1) * 2);
+  return 0;
 }
 
 off_t cUnbufferedFile::Seek(off_t Offset, int Whence)
@@ -1902,14 +2173,26 @@ ssize_t cUnbufferedFile::Read(void *Data, size_t Size)
         FadviseDrop(cachedstart, cachedend-cachedstart);
         cachedstart = curpos;
         cachedend = curpos;
+        prefetchstart = prefetchend = 0; // any prefetched data has been dropped, too
         }
      cachedstart = min(cachedstart, curpos);
 #endif
      ssize_t bytesRead = safe_read(fd, Data, Size);
      if (bytesRead > 0) {
+        UnbufferedFileCoordinator.Read(this, curpos, bytesRead);
         curpos += bytesRead;
 #if USE_FADVISE_READ
         cachedend = max(cachedend, curpos);
+        if (prefetchstart < prefetchend) {
+           // Prefetched data that has been passed in the current direction of
+           // reading is handled like any other data that has been read:
+           if (jumped < 0)
+              prefetchend = min(prefetchend, curpos - bytesRead);
+           else
+              prefetchstart = max(prefetchstart, curpos);
+           if (prefetchstart >= prefetchend)
+              prefetchstart = prefetchend = 0;
+           }
 
         // Read ahead:
         // no jump? (allow small forward jump still inside readahead window).
@@ -1918,7 +2201,8 @@ ssize_t cUnbufferedFile::Read(void *Data, size_t Size)
            // 1/2 of the previously requested area. This avoids calling
            // fadvise() after every read() call.
            if (ahead - curpos < (off_t)(readahead / 2)) {
-              posix_fadvise(fd, curpos, readahead, POSIX_FADV_WILLNEED);
+              if (!UnbufferedFileCoordinator.Shared(this, curpos, readahead))
+                 posix_fadvise(fd, curpos, readahead, POSIX_FADV_WILLNEED);
               ahead = curpos + readahead;
               cachedend = max(cachedend, ahead);
               }
@@ -1932,15 +2216,27 @@ ssize_t cUnbufferedFile::Read(void *Data, size_t Size)
         }
 #if USE_FADVISE_READ
      if (cachedstart < cachedend) {
+        // prefetched data that hasn't been read yet is kept:
+        bool Prefetched = prefetchstart < prefetchend;
         if (curpos - cachedstart > READCHUNK * 2) {
            // current position has moved forward enough, shrink tail window.
-           FadviseDrop(cachedstart, curpos - READCHUNK - cachedstart);
-           cachedstart = curpos - READCHUNK;
+           off_t end = curpos - READCHUNK;
+           if (Prefetched)
+              end = min(end, prefetchstart);
+           if (end > cachedstart) {
+              FadviseDrop(cachedstart, end - cachedstart);
+              cachedstart = end;
+              }
            }
-        else if (cachedend > ahead && cachedend - curpos > READCHUNK * 2) {
+        if (cachedend > ahead && cachedend - curpos > READCHUNK * 2) {
            // current position has moved back enough, shrink head window.
-           FadviseDrop(curpos + READCHUNK, cachedend - (curpos + READCHUNK));
-           cachedend = curpos + READCHUNK;
+           off_t start = curpos + READCHUNK;
+           if (Prefetched)
+              start = max(start, prefetchend);
+           if (start < cachedend) {
+              FadviseDrop(start, cachedend - start);
+              cachedend = start;
+              }
            }
         }
      lastpos = curpos;
@@ -1950,7 +2246,49 @@ ssize_t cUnbufferedFile::Read(void *Data, size_t Size)
   return -1;
 }
 
+void cUnbufferedFile::Prefetch(off_t Offset, size_t Size)
+{
+  if (fd >= 0 && Size > 0) {
+     if (!UnbufferedFileCoordinator.Shared(this, Offset, Size))
+        posix_fadvise(fd, Offset, Size, POSIX_FADV_WILLNEED);
+#if USE_FADVISE_READ
+     // Extend the cached window, so that Read() drops the prefetched data
+     // once it is no longer needed:
+     off_t end = Offset + Size;
+     if (cachedstart >= cachedend)
+        cachedstart = cachedend = curpos;
+     cachedstart = min(cachedstart, Offset);
+     cachedend = max(cachedend, end);
+     if (prefetchstart < prefetchend) {
+        prefetchstart = min(prefetchstart, Offset);
+        prefetchend = max(prefetchend, end);
+        }
+     else {
+        prefetchstart = Offset;
+        prefetchend = end;
+        }
+#endif
+     }
+}
+
 ssize_t cUnbufferedFile::Write(const void *Data, size_t Size)
+{
+  if (writer)
+     return writer->Put(Data, Size);
+  return WriteData(Data, Size);
+}
+
+bool cUnbufferedFile::Flush(void)
+{
+  return writer ? writer->Flush() : fd >= 0;
+}
+
+off_t cUnbufferedFile::Written(void)
+{
+  return writer ? writer->Written() : curpos;
+}
+
+ssize_t cUnbufferedFile::WriteData(const void *Data, size_t Size)
 {
   if (fd >=0) {
      ssize_t bytesWritten = safe_write(fd, Data, Size);
@@ -1971,7 +2309,7 @@ ssize_t cUnbufferedFile::Write(const void *Data, size_t Size)
               //    second call; the third call will still include this page and finally
               //    drop it from cache.
               off_t headdrop = min(begin, off_t(WRITE_BUFFER * 2));
-              posix_fadvise(fd, begin - headdrop, lastpos - begin + headdrop, POSIX_FADV_DONTNEED);
+              UnbufferedFileCoordinator.Drop(this, begin - headdrop, lastpos - begin + headdrop);
               }
            begin = lastpos = curpos;
            totwritten += written;
@@ -1990,7 +2328,7 @@ ssize_t cUnbufferedFile::Write(const void *Data, size_t Size)
               // Uncomment the next line if you think you need them.
               //fdatasync(fd);
               off_t headdrop = min(off_t(curpos - totwritten), off_t(totwritten * 2));
-              posix_fadvise(fd, curpos - totwritten - headdrop, totwritten + headdrop, POSIX_FADV_DONTNEED);
+              UnbufferedFileCoordinator.Drop(this, curpos - totwritten - headdrop, totwritten + headdrop);
               totwritten = 0;
               }
            }
@@ -2011,6 +2349,11 @@ cUnbufferedFile *cUnbufferedFile::Create(const char *FileName, int Flags, mode_t
   return File;
 }
 
+cString cUnbufferedFile::Metrics(void)
+{
+  return UnbufferedFileCoordinator.Metrics();
+}
+
 // --- cLockFile -------------------------------------------------------------
 
 #define LOCKFILENAME      ".lock-vdr"
@@ -504,29 +504,67 @@ public:
 /// cUnbufferedFile is used for large files that are mainly written or read
 /// in a streaming manner, and thus should not be cached.
 
+class cUnbufferedFileWriter;
+class cUnbufferedFileCoordinator;
+
 class cUnbufferedFile {
+  friend class cUnbufferedFileWriter;
+  friend class cUnbufferedFileCoordinator;
 private:
   int fd;
+  dev_t dev;
+  ino_t ino;
+  off_t readpos;
   off_t curpos;
   off_t cachedstart;
   off_t cachedend;
+  off_t prefetchstart;
+  off_t prefetchend;
   off_t begin;
   off_t lastpos;
   off_t ahead;
   size_t readahead;
   size_t written;
   size_t totwritten;
+  cUnbufferedFileWriter *writer;
   int FadviseDrop(off_t Offset, off_t Len);
+  ssize_t WriteData(const void *Data, size_t Size);
 public:
   cUnbufferedFile(void);
   ~cUnbufferedFile();
   int Open(const char *FileName, int Flags, mode_t Mode = DEFFILEMODE);
   int Close(void);
   void SetReadAhead(size_t ra);
+  void SetAsyncWrite(int BufferSize);
+       ///< Makes all following calls to Write() just copy the data into a buffer
+       ///< of (twice) the given size, which is written to the file by a separate
+       ///< thread. Write() only blocks if this buffer is full. An error that occurs
+       ///< while writing is reported by the next call to Write(), Flush() or Close().
+       ///< This is only meant for files that are written sequentially, without
+       ///< calling Seek() or Read() in between.
   off_t Seek(off_t Offset, int Whence);
   ssize_t Read(void *Data, size_t Size);
+  void Prefetch(off_t Offset, size_t Size);
+       ///< Tells the operating system that the Size bytes at the given Offset will
+       ///< be read soon, so that it can start reading them in the background.
+       ///< This doesn't change the current file position. The prefetched data is
+       ///< dropped from the cache like any other data that has been read, once the
+       ///< file position has moved away from it.
+       ///< Must not be called while another thread is in Read().
   ssize_t Write(const void *Data, size_t Size);
+  bool Flush(void);
+       ///< Waits until all data given to Write() has actually been written to the file.
+       ///< Returns false in case of an error.
+  off_t Written(void);
+       ///< Returns the file position up to which the data given to Write() has
+       ///< actually been written to the file.
   static cUnbufferedFile *Create(const char *FileName, int Flags, mode_t Mode = DEFFILEMODE);
+  static cString Metrics(void);
+       ///< Returns statistics about files that are read by several cUnbufferedFile
+       ///< objects at the same time (e.g. a recording that is replayed locally and
+       ///< streamed to clients), in the form "key=value key=value...". Such objects
+       ///< don't drop data from the file system cache that another one is about to
+       ///< read, and don't request read-ahead of data another one has just read.
   };
 
 class cLockFile {
@@ -50,12 +50,14 @@
 #include "dvbdevice.h"
 #include "eitscan.h"
 #include "epg.h"
+#include "filedevice.h"
 #include "i18n.h"
 #include "interface.h"
 #include "keys.h"
 #include "libsi/si.h"
 #include "lirc.h"
 #include "menu.h"
+#include "metrics.h"
 #include "osdbase.h"
 #include "plugin.h"
 #include "recording.h"
@@ -239,6 +241,7 @@ int main(int argc, char *argv[])
   int WatchdogTimeout = DEFAULTWATCHDOG;
   const char *Terminal = NULL;
   const char *OverrideCharacterTable = NULL;
+  cStringList TsFiles;
 
   bool UseKbd = true;
   const char *LircDevice = NULL;
@@ -287,6 +290,7 @@ int main(int argc, char *argv[])
       { "lirc",     optional_argument, NULL, 'l' | 0x100 },
       { "localedir",required_argument, NULL, 'l' | 0x200 },
       { "log",      required_argument, NULL, 'l' },
+      { "metrics",  required_argument, NULL, 'm' | 0x100 },
       { "mute",     no_argument,       NULL, 'm' },
       { "no-kbd",   no_argument,       NULL, 'n' | 0x100 },
       { "plugin",   required_argument, NULL, 'P' },
@@ -297,6 +301,7 @@ int main(int argc, char *argv[])
       { "shutdown", required_argument, NULL, 's' },
       { "split",    no_argument,       NULL, 's' | 0x100 },
       { "terminal", required_argument, NULL, 't' },
+      { "tsfile",   required_argument, NULL, 't' | 0x100 },
       { "updindex", required_argument, NULL, 'u' | 0x200 },
       { "user",     required_argument, NULL, 'u' },
       { "userdump", no_argument,       NULL, 'u' | 0x100 },
@@ -453,6 +458,9 @@ int main(int argc, char *argv[])
                     break;
           case 'm': MuteAudio = true;
                     break;
+          case 'm' | 0x100:
+                    cMetrics::SetFileName(optarg);
+                    break;
           case 'n' | 0x100:
                     UseKbd = false;
                     break;
@@ -494,6 +502,9 @@ int main(int argc, char *argv[])
                        return 2;
                        }
                     break;
+          case 't' | 0x100:
+                    TsFiles.Append(strdup(optarg));
+                    break;
           case 'u': if (*optarg)
                        VdrUser = optarg;
                     break;
@@ -584,6 +595,8 @@ int main(int argc, char *argv[])
                "                           (default: %s)\n"
                "            --localedir=DIR search for locale files in DIR (default is\n"
                "                           %s)\n"
+               "            --metrics=FILE write runtime metrics into FILE every 10 seconds\n"
+               "                           (see the SVDRP command STAT METRICS)\n"
                "  -m,       --mute         mute audio of the primary DVB device at startup\n"
                "            --no-kbd       don't use the keyboard as an input device\n"
                "  -p PORT,  --port=PORT    use PORT for SVDRP (default: %d)\n"
@@ -598,6 +611,11 @@ int main(int argc, char *argv[])
                "            --showargs[=DIR] print the arguments read from DIR and exit\n"
                "                           (default: %s)\n"
                "  -t TTY,   --terminal=TTY controlling tty\n"
+               "            --tsfile=FILE[,fast]\n"
+               "                           use a device that receives the Transport Stream in\n"
+               "                           FILE instead of DVB hardware; FILE is read in real\n"
+               "                           time, or as fast as possible if ',fast' is given;\n"
+               "                           there may be several --tsfile options\n"
                "  -u USER,  --user=USER    run as user USER; only applicable if started as\n"
                "                           root; USER can be a user name or a numerical id\n"
                "            --userdump     allow coredumps if -u is given (debugging)\n"
@@ -808,6 +826,20 @@ int main(int argc, char *argv[])
   cDvbDevice::Initialize();
   cDvbDevice::BondDevices(Setup.DeviceBondings);
 
+  // TS file devices:
+
+  for (int i = 0; i < TsFiles.Size(); i++) {
+      char *FileName = TsFiles[i];
+      bool Unlimited = false;
+      if (char *p = strrchr(FileName, ',')) {
+         if (strcmp(p + 1, "fast") == 0) {
+            *p = 0;
+            Unlimited = true;
+            }
+         }
+      new cFileDevice(FileName, Unlimited);
+      }
+
   // Initialize plugins:
 
   if (!PluginManager.InitializePlugins())
@@ -1597,6 +1629,7 @@ int main(int argc, char *argv[])
         cReplayControl::DelTimeshiftTimer();
 
         ReportEpgBugFixStats();
+        cMetrics::Process();
 
         // Main thread hooks of plugins:
         PluginManager.MainThreadHook();